@@ -0,0 +1,109 @@
+#pragma once
+// Benchmarks of the kernels which don't fit into the signature of dotProduct<eDotProductAlgorithm> function, and other commands.
+// They're selected on the command line by name. The remaining arguments are passed to the function, it returns the exit code of the process.
+
+// Call the function several times, return the fastest time in microseconds
+template<class TFunc>
+inline double bestTime( int repeats, TFunc func )
+{
+	double result = std::numeric_limits<double>::max();
+	for( int i = 0; i < repeats; i++ )
+	{
+		const Stopwatch stopwatch;
+		func();
+		result = std::min( result, stopwatch.elapsedMicroseconds() );
+	}
+	return result;
+}
+
+// Parse the optional length argument of the benchmark, print a message and return false if it's invalid
+inline bool parseLength( int argc, const char* argv[], size_t& length )
+{
+	if( argc < 1 )
+		return true;
+	int i;
+	if( nonstd::atoi( argv[ 0 ], i ) && i > 0 )
+	{
+		length = (size_t)i;
+		return true;
+	}
+	printf( "Invalid length \"%s\"\n", argv[ 0 ] );
+	return false;
+}
+
+// Print time, bandwidth, speedup relative to the baseline, and relative error of the result
+inline void printResult( const char* name, double us, double bytes, float result, long double reference, double usBaseline )
+{
+	const double error = (double)( std::abs( (long double)result - reference ) / std::abs( reference ) );
+	printf( "%s: %g us, %.1f GB/s, %.2fx faster, result %g, relative error %g\n",
+		name, us, bytes / us * 1E-3, usBaseline / us, (double)result, error );
+}
+
+// Dot products of vectors in a memory-mapped raw float32 file: time of the page faults versus compute
+int benchmarkFile( int argc, const char* argv[] );
+
+// Millions of dot products of 16, 32 and 64 floats, the length known at compile time versus runtime
+int benchmarkFixed( int argc, const char* argv[] );
+
+// The fixed benchmark cycles through this count of pairs of vectors
+constexpr size_t fixedPairs = 1024;
+// Measurement loops of the fixed benchmark, compiled for AVX2 + FMA3 with the kernels inlined: sum of the dot products of the pairs of vectors, cycling through them.
+// With dependent = true, the address of every pair depends on the previous result, to measure latency instead of throughput.
+// fixedLengthLoop uses avx_vertical_fixed<length>, runtimeLengthLoop uses avx_vertical_multi<4> with the length only known at runtime.
+template<size_t length>
+float fixedLengthLoop( const float* p1, const float* p2, size_t calls, bool dependent );
+float runtimeLengthLoop( const float* p1, const float* p2, size_t length, size_t calls, bool dependent );
+
+// Matrix multiplication with the register-tiled micro-kernel, versus a naive triple loop; prints GFLOP/s
+int benchmarkGemm( int argc, const char* argv[] );
+
+// Batched dot products of a vector with many rows of a matrix, versus a loop which calls dotProduct for every row
+int benchmarkGemv( int argc, const char* argv[] );
+
+// Verify all algorithms supported by the CPU against a long double reference, for all lengths from 0 to 257 floats
+int checkLengths( int argc, const char* argv[] );
+
+// Dot products of half-precision and bfloat16 copies of the vectors, versus the fp32 kernel
+int benchmarkHalf( int argc, const char* argv[] );
+
+// Dot products of 8-bit quantized copies of the vectors, versus the fp32 kernel
+int benchmarkInt8( int argc, const char* argv[] );
+
+// Sweep prefetch distances of the prefetching versions, with the data evicted from caches
+int benchmarkPrefetch( int argc, const char* argv[] );
+
+// Every supported algorithm, for vector lengths from L1D to DRAM sizes, with min / median / 99th percentile of the time; prints CSV or JSON
+int benchmarkSweep( int argc, const char* argv[] );
+
+// Independent dot products of 8-48 floats in structure-of-arrays layout, versus a loop over AvxVerticalFma
+int benchmarkSoa( int argc, const char* argv[] );
+
+// Sparse * dense dot products, scalar and gather versions, versus densifying the sparse vector, for densities from 0.1% to 100%
+int benchmarkSparse( int argc, const char* argv[] );
+
+// Sparse * sparse dot products, scalar merge and SIMD intersection, versus densifying both vectors, for overlap ratios from 0 to 100%
+int benchmarkSparseSparse( int argc, const char* argv[] );
+
+// Cosine similarity computed in a single pass, versus 3 dot products
+int benchmarkCosine( int argc, const char* argv[] );
+
+// Random vector generation: the serial generator fillRandomVector used before, versus the counter-based one with SSE2 and AVX2, on 1 and all threads
+int benchmarkRandom( int argc, const char* argv[] );
+
+// Squared L2 and L1 distances, sum, min, max and argmax, with 1-4 accumulators; verifies them against scalar code
+int benchmarkReduce( int argc, const char* argv[] );
+
+// Hamming distances of 256, 512 and 1024-bit binary vectors: single pair, one to many and top-k, scalar POPCNT versus AVX2
+int benchmarkHamming( int argc, const char* argv[] );
+
+// Reproducible dot product: verifies bitwise identical results for all instruction sets, accumulators and thread counts, prints throughput relative to AvxVerticalFma4
+int benchmarkReproducible( int argc, const char* argv[] );
+
+// Queries per second of the brute-force top-k search, single and multi-threaded
+int benchmarkSearch( int argc, const char* argv[] );
+
+// Product quantization scan with pshufb lookup tables, versus exhaustive dot products: throughput and recall
+int benchmarkPq( int argc, const char* argv[] );
+
+// Out-of-core dot product of a raw float32 file, reads overlapped with compute, versus the raw read bandwidth
+int benchmarkStreaming( int argc, const char* argv[] );
\ No newline at end of file
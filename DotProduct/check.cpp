@@ -0,0 +1,62 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// Lengths from 0 to this value are tested, covering all remainders of every algorithm several times.
+constexpr size_t checkMaxLength = 257;
+// Pointer offsets to test, in floats. Odd ones make the vectors misaligned.
+static const std::array<size_t, 3> s_checkOffsets = { 0, 1, 3 };
+
+// Returns true if the algorithm passed the test, prints the first failure otherwise.
+static bool checkAlgorithm( eDotProductAlgorithm algo, const float* v1, const float* v2 )
+{
+	const pfnDotProduct pfn = dotProductFunc( algo );
+	for( size_t offset : s_checkOffsets )
+	{
+		// Different offsets for the two vectors, to also test when they're misaligned relative to each other.
+		const float* const p1 = v1 + offset;
+		const float* const p2 = v2 + s_checkOffsets.back() - offset;
+		for( size_t count = 0; count <= checkMaxLength; count++ )
+		{
+			const long double reference = referenceDotProduct( p1, p2, count );
+			const float result = pfn( p1, p2, count );
+			// The random numbers are non-negative, this makes the reference value an upper bound of the rounding errors.
+			const long double tolerance = reference * (long double)( count + 1 ) * FLT_EPSILON;
+			if( std::abs( (long double)result - reference ) <= tolerance )
+				continue;
+			printf( "%s: FAILED, count %i, offset %i, expected %g, got %g\n", algorithmName( algo ), (int)count, (int)offset, (double)reference, (double)result );
+			return false;
+		}
+	}
+	printf( "%s: OK\n", algorithmName( algo ) );
+	return true;
+}
+
+int checkLengths( int argc, const char* argv[] )
+{
+	if( argc > 0 )
+	{
+		printf( "Unexpected argument \"%s\", check command doesn't take any\n", argv[ 0 ] );
+		return 2;
+	}
+
+	// Long enough for the largest offset
+	const size_t bufferLength = checkMaxLength + s_checkOffsets.back();
+	auto v1 = alignedArray<float>( bufferLength );
+	auto v2 = alignedArray<float>( bufferLength );
+	fillRandomVector( true, v1.get(), bufferLength, 11 );
+	fillRandomVector( true, v2.get(), bufferLength, 12 );
+
+	int failed = 0;
+	for( uint8_t i = 0; i < (uint8_t)eDotProductAlgorithm::valuesCount; i++ )
+	{
+		const eDotProductAlgorithm algo = (eDotProductAlgorithm)i;
+		if( !isSupported( requiredInstructionSet( algo ) ) )
+		{
+			printf( "%s: skipped, requires %s\n", algorithmName( algo ), instructionSetName( requiredInstructionSet( algo ) ) );
+			continue;
+		}
+		if( !checkAlgorithm( algo, v1.get(), v2.get() ) )
+			failed++;
+	}
+	return 0 == failed ? 0 : 1;
+}
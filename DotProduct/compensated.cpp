@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Compensated summation, more precise than the vertical versions. This source file is compiled for AVX2 + FMA3.
+
+// Running sum of 8 lanes, along with the rounding error for each lane. The exact sum is approximately sum + error.
+struct CompensatedSum
+{
+	__m256 sum, error;
+};
+
+// Add a * b to the compensated sum.
+// When twoSum is false, it's Kahan summation, the product is rounded but FMA folds the previous error into that single rounding.
+// When true, it's Dot2 algorithm from Ogita, Rump and Oishi: exact products with FMA-based TwoProduct, and TwoSum which doesn't depend on the magnitudes of the operands like Neumaier's variant of Kahan.
+template<bool twoSum>
+__forceinline void compensatedAdd( CompensatedSum& acc, __m256 a, __m256 b )
+{
+	if constexpr( twoSum )
+	{
+		// TwoProduct: p + pe == a * b exactly
+		const __m256 p = _mm256_mul_ps( a, b );
+		const __m256 pe = _mm256_fmsub_ps( a, b, p );
+		// TwoSum: s + se == acc.sum + p exactly
+		const __m256 s = _mm256_add_ps( acc.sum, p );
+		const __m256 z = _mm256_sub_ps( s, acc.sum );
+		const __m256 se = _mm256_add_ps( _mm256_sub_ps( acc.sum, _mm256_sub_ps( s, z ) ), _mm256_sub_ps( p, z ) );
+		acc.sum = s;
+		acc.error = _mm256_add_ps( acc.error, _mm256_add_ps( pe, se ) );
+	}
+	else
+	{
+		// Kahan: y = a * b + error with a single rounding, the error is whatever was lost in the previous addition
+		const __m256 y = _mm256_fmadd_ps( a, b, acc.error );
+		const __m256 t = _mm256_add_ps( acc.sum, y );
+		acc.error = _mm256_sub_ps( y, _mm256_sub_ps( t, acc.sum ) );
+		acc.sum = t;
+	}
+}
+
+// Sum all 8 lanes of both sum and error, in double precision.
+__forceinline double hadd_pd( const CompensatedSum& acc )
+{
+	const __m128 sumLow = _mm256_castps256_ps128( acc.sum );
+	const __m128 sumHigh = _mm256_extractf128_ps( acc.sum, 1 );
+	const __m128 errorLow = _mm256_castps256_ps128( acc.error );
+	const __m128 errorHigh = _mm256_extractf128_ps( acc.error, 1 );
+	// Convert to doubles, 4 lanes / each
+	const __m256d sum = _mm256_add_pd( _mm256_cvtps_pd( sumLow ), _mm256_cvtps_pd( sumHigh ) );
+	const __m256d error = _mm256_add_pd( _mm256_cvtps_pd( errorLow ), _mm256_cvtps_pd( errorHigh ) );
+	const __m256d r4 = _mm256_add_pd( sum, error );
+	const __m128d r2 = _mm_add_pd( _mm256_castpd256_pd128( r4 ), _mm256_extractf128_pd( r4, 1 ) );
+	const __m128d r1 = _mm_add_sd( r2, _mm_unpackhi_pd( r2, r2 ) );
+	return _mm_cvtsd_f64( r1 );
+}
+
+template<int accumulators, bool twoSum>
+__forceinline float avx_compensated_multi( const float* p1, const float* p2, size_t count )
+{
+	static_assert( accumulators > 0 && accumulators <= 4 );
+	constexpr int valuesPerLoop = accumulators * 8;
+	const size_t remainder = count % valuesPerLoop;
+	const float* const p1End = p1 + ( count - remainder );
+
+	CompensatedSum acc[ accumulators ];
+	for( int i = 0; i < accumulators; i++ )
+		acc[ i ] = CompensatedSum{ _mm256_setzero_ps(), _mm256_setzero_ps() };
+
+	for( ; p1 < p1End; p1 += valuesPerLoop, p2 += valuesPerLoop )
+	{
+		for( int i = 0; i < accumulators; i++ )
+			compensatedAdd<twoSum>( acc[ i ], _mm256_loadu_ps( p1 + i * 8 ), _mm256_loadu_ps( p2 + i * 8 ) );
+	}
+
+	// Up to 3 remaining complete vectors, then the remaining 1-7 floats with masked loads.
+	// Zeros in the masked out lanes are added exactly, they don't change neither sum nor error.
+	const float* const p1EndVectors = p1 + ( remainder - remainder % 8 );
+	for( ; p1 < p1EndVectors; p1 += 8, p2 += 8 )
+		compensatedAdd<twoSum>( acc[ 0 ], _mm256_loadu_ps( p1 ), _mm256_loadu_ps( p2 ) );
+	if( 0 != remainder % 8 )
+	{
+		const __m256i mask = remainderMask( remainder % 8 );
+		compensatedAdd<twoSum>( acc[ 0 ], _mm256_maskload_ps( p1, mask ), _mm256_maskload_ps( p2, mask ) );
+	}
+
+	// Add the accumulators in double precision, it's only done once and that precision is cheap.
+	double result = 0;
+	for( int i = 0; i < accumulators; i++ )
+		result += hadd_pd( acc[ i ] );
+	return (float)result;
+}
+
+template<>
+float dotProduct<eDotProductAlgorithm::AvxKahanFma2>( const float* p1, const float* p2, size_t count )
+{
+	return avx_compensated_multi<2, false>( p1, p2, count );
+}
+template<>
+float dotProduct<eDotProductAlgorithm::AvxKahanFma4>( const float* p1, const float* p2, size_t count )
+{
+	return avx_compensated_multi<4, false>( p1, p2, count );
+}
+template<>
+float dotProduct<eDotProductAlgorithm::AvxDot2Fma2>( const float* p1, const float* p2, size_t count )
+{
+	return avx_compensated_multi<2, true>( p1, p2, count );
+}
+template<>
+float dotProduct<eDotProductAlgorithm::AvxDot2Fma4>( const float* p1, const float* p2, size_t count )
+{
+	return avx_compensated_multi<4, true>( p1, p2, count );
+}
@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Cosine similarity, this source file is compiled for AVX2 + FMA3.
+
+// a·b, a·a and b·b in a single pass over both vectors.
+// Every load feeds 2 of the 3 FMAs, and each of the 3 products has `accumulators` independent chains to hide the latency of FMA.
+template<int accumulators>
+__forceinline sDotProducts avx_fused_multi( const float* p1, const float* p2, size_t count )
+{
+	static_assert( accumulators > 0 && accumulators <= 3 );
+	constexpr int valuesPerLoop = accumulators * 8;
+	const size_t remainder = count % valuesPerLoop;
+	const float* const p1End = p1 + ( count - remainder );
+
+	__m256 ab[ accumulators ], aa[ accumulators ], bb[ accumulators ];
+	for( int i = 0; i < accumulators; i++ )
+		ab[ i ] = aa[ i ] = bb[ i ] = _mm256_setzero_ps();
+
+	for( ; p1 < p1End; p1 += valuesPerLoop, p2 += valuesPerLoop )
+	{
+		for( int i = 0; i < accumulators; i++ )
+		{
+			const __m256 a = _mm256_loadu_ps( p1 + i * 8 );
+			const __m256 b = _mm256_loadu_ps( p2 + i * 8 );
+			ab[ i ] = _mm256_fmadd_ps( a, b, ab[ i ] );
+			aa[ i ] = _mm256_fmadd_ps( a, a, aa[ i ] );
+			bb[ i ] = _mm256_fmadd_ps( b, b, bb[ i ] );
+		}
+	}
+
+	// Up to 2 remaining complete vectors, then the remaining 1-7 floats with masked loads
+	size_t rem = remainder;
+	for( ; rem >= 8; rem -= 8, p1 += 8, p2 += 8 )
+	{
+		const __m256 a = _mm256_loadu_ps( p1 );
+		const __m256 b = _mm256_loadu_ps( p2 );
+		ab[ 0 ] = _mm256_fmadd_ps( a, b, ab[ 0 ] );
+		aa[ 0 ] = _mm256_fmadd_ps( a, a, aa[ 0 ] );
+		bb[ 0 ] = _mm256_fmadd_ps( b, b, bb[ 0 ] );
+	}
+	if( rem > 0 )
+	{
+		const __m256i mask = remainderMask( rem );
+		const __m256 a = _mm256_maskload_ps( p1, mask );
+		const __m256 b = _mm256_maskload_ps( p2, mask );
+		ab[ 0 ] = _mm256_fmadd_ps( a, b, ab[ 0 ] );
+		aa[ 0 ] = _mm256_fmadd_ps( a, a, aa[ 0 ] );
+		bb[ 0 ] = _mm256_fmadd_ps( b, b, bb[ 0 ] );
+	}
+
+	for( int i = 1; i < accumulators; i++ )
+	{
+		ab[ 0 ] = _mm256_add_ps( ab[ 0 ], ab[ i ] );
+		aa[ 0 ] = _mm256_add_ps( aa[ 0 ], aa[ i ] );
+		bb[ 0 ] = _mm256_add_ps( bb[ 0 ], bb[ i ] );
+	}
+	return sDotProducts{ hadd_ps( ab[ 0 ] ), hadd_ps( aa[ 0 ] ), hadd_ps( bb[ 0 ] ) };
+}
+
+sDotProducts fusedDotProducts( const float* p1, const float* p2, size_t count )
+{
+	// 3 accumulators per product = 9 independent FMA chains, enough to saturate 2 FMA ports with 4-5 cycles latency
+	return avx_fused_multi<3>( p1, p2, count );
+}
+
+float cosineSimilarity( const float* p1, const float* p2, size_t count )
+{
+	const sDotProducts dp = fusedDotProducts( p1, p2, count );
+	const double denominator = std::sqrt( (double)dp.aa * (double)dp.bb );
+	if( 0 == denominator )
+		return 0;
+	return (float)( dp.ab / denominator );
+}
+
+float normalizedL2Distance( const float* p1, const float* p2, size_t count )
+{
+	// |a/|a| - b/|b||^2 = 2 - 2 * cos( a, b ). Rounding errors may make it slightly negative for equal vectors.
+	const float cosine = cosineSimilarity( p1, p2, count );
+	return std::sqrt( std::max( 2.0f - 2.0f * cosine, 0.0f ) );
+}
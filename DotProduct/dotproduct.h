@@ -1,7 +1,7 @@
 ﻿#pragma once
 #include "../common.h"
 
-// Fill the buffer with uniformly-distributed random floats in the range [0 .. +1)
+// Fill the buffer with uniformly-distributed random floats in the range [0 .. +1). Generated with SIMD on all threads, the numbers only depend on the seed.
 void fillRandomVector( bool cacheData, float* ptr, size_t count, uint32_t randomSeed );
 
 enum struct eDotProductAlgorithm : uint8_t
@@ -24,6 +24,25 @@ enum struct eDotProductAlgorithm : uint8_t
 	SseVerticalFma4,
 	AvxVerticalFma4,
 	SseVertical4,
+	AvxVertical4,
+
+	// AvxVerticalFma4 running on all hardware threads of the computer
+	ParallelAvxFma4,
+
+	// Compensated summation with 2 or 4 accumulators: Kahan, and TwoProduct + TwoSum
+	AvxKahanFma2,
+	AvxKahanFma4,
+	AvxDot2Fma2,
+	AvxDot2Fma4,
+
+	// AvxVerticalFma4 with software prefetch, to the L1D cache or non-temporal. The distance is set with setPrefetchDistance function.
+	AvxVerticalFma4PrefetchT0,
+	AvxVerticalFma4PrefetchNta,
+
+	// Reproducible summation, bitwise identical results for all of them: SSE2 with 2 accumulators, AVX with 4, and AVX or SSE2 on all hardware threads
+	SseReproducible,
+	AvxReproducible,
+	ParallelReproducible,
 
 	valuesCount,
 };
@@ -31,9 +50,114 @@ enum struct eDotProductAlgorithm : uint8_t
 // Get the name of the algorithm, or nullptr if the argument is invalid.
 const char* algorithmName( eDotProductAlgorithm algo );
 
-// Run the specified algorithm, print time along with the resulting dot product.
+// Get the instruction set the algorithm requires.
+eInstructionSet requiredInstructionSet( eDotProductAlgorithm algo );
+
+// The fastest single-threaded algorithm supported by this CPU, selected once on the first call.
+eDotProductAlgorithm fastestAlgorithm();
+
+using pfnDotProduct = float( *)( const float* p1, const float* p2, size_t count );
+// Get function pointer to the specialized version of dotProduct<> template function, or nullptr if the argument is invalid.
+pfnDotProduct dotProductFunc( eDotProductAlgorithm algo );
+
+// How far ahead the prefetch versions are loading the data, in bytes. The default is 1kb.
+void setPrefetchDistance( size_t bytes );
+size_t getPrefetchDistance();
+
+// Dot product computed with extended precision, to measure errors of the algorithms.
+long double referenceDotProduct( const float* p1, const float* p2, size_t count );
+
+// Dot product which doesn't depend on the instruction set, count of accumulators 1-4, or count of threads: all combinations produce bitwise identical results.
+// The instruction set is Sse2 or Avx, higher ones use the AVX version. The threads are taken from the shared pool, 1 means the calling thread.
+float reproducibleDotProduct( const float* p1, const float* p2, size_t count, eInstructionSet isa, int accumulators, size_t threads );
+
+// Run the specified algorithm, print time along with the resulting dot product, and its relative error.
 void dispatchAndMeasure( eDotProductAlgorithm algo, const float* p1, const float* p2, size_t count );
 
-// Various *.cpp source files in this project are implementing specialized versions of this function.
+// Various *.cpp source files in this project are implementing specialized versions of this function. All of them support any count of elements.
 template<eDotProductAlgorithm algo>
-float dotProduct( const float* p1, const float* p2, size_t count );
\ No newline at end of file
+float dotProduct( const float* p1, const float* p2, size_t count );
+
+// Multiply row-major matrices, c[ m * n ] = a[ m * k ] * b[ k * n ], with 6x16 register tiles and packed blocks of both inputs. Requires AVX2 + FMA3.
+void matrixProduct( const float* a, const float* b, float* c, size_t m, size_t n, size_t k );
+
+// Dot product of short vectors with the length known at compile time, fully unrolled. Instantiated for 16, 32 and 64 floats, requires AVX2 + FMA3.
+template<size_t count>
+float dotProductFixed( const float* p1, const float* p2 );
+
+// Compute dot products of the vector with each row of the row-major matrix, and write `rows` results. Requires AVX2 + FMA3.
+void matrixVectorProduct( const float* matrix, size_t rows, const float* vec, size_t count, float* result );
+
+// Many independent dot products of short vectors in structure-of-arrays layout: the pairs are grouped in blocks of 8, within a block the elements are interleaved.
+// Element j of vector 8 * k + i is at [ ( k * length + j ) * 8 + i ], the last block is padded with zeros, the arrays take ( pairs + 7 ) / 8 * 8 * length floats.
+// Transpose `pairs` sequential vectors of `length` floats into that layout. The destination must be aligned by 32 bytes. Requires AVX2 + FMA3.
+void transposeToSoA( const float* src, size_t pairs, size_t length, float* dst );
+// Compute dot products of the vectors in these layouts, 8 pairs per AVX vector without horizontal additions, write `pairs` results. Requires AVX2 + FMA3.
+void dotProductsSoA( const float* a, const float* b, size_t pairs, size_t length, float* result );
+
+// 16-bit floating point formats, for the vectors stored in uint16_t arrays
+enum struct eHalfFormat : uint8_t
+{
+	// IEEE 754 half precision: 5 bits exponent, 10 bits mantissa
+	Fp16,
+	// bfloat16: upper half of fp32, 8 bits exponent, 7 bits mantissa
+	Bf16,
+};
+
+// Convert floats to the 16-bit format, rounding to nearest even. Requires AVX2 + FMA3.
+void convertToHalf( eHalfFormat format, const float* src, uint16_t* dst, size_t count );
+
+// Dot product of 16-bit vectors, converted to fp32 in registers and accumulated in fp32. Requires AVX2 + FMA3.
+float dotProductHalf( eHalfFormat format, const uint16_t* p1, const uint16_t* p2, size_t count );
+
+// Quantize the vector to signed bytes in [ -127, 127 ] interval, return the scale: src[ i ] ~= scale * dst[ i ]
+float quantizeInt8( const float* src, int8_t* dst, size_t count );
+// Quantize non-negative vector to unsigned bytes, return the scale. Negative values become zeros.
+float quantizeUint8( const float* src, uint8_t* dst, size_t count );
+
+// Dot products of quantized vectors, computed exactly with int32 and int64 accumulators, then multiplied by both scales. Require AVX2 + FMA3.
+// Signed bytes must be in [ -127, 127 ] interval like quantizeInt8 makes them, unsigned ones can use the complete [ 0 .. 255 ] range.
+float dotProductInt8( const int8_t* p1, float scale1, const int8_t* p2, float scale2, size_t count );
+float dotProductUint8( const uint8_t* p1, float scale1, const int8_t* p2, float scale2, size_t count );
+
+// Dot product of a sparse vector with a dense one. The sparse vector has `count` non-zero elements, dense[ indices[ i ] ] is multiplied by values[ i ].
+// The indices don't need to be sorted, but they need to be less than 2^31. The scalar version runs on any CPU, the other one requires AVX2 + FMA3.
+float sparseDotProductScalar( const uint32_t* indices, const float* values, size_t count, const float* dense );
+float sparseDotProduct( const uint32_t* indices, const float* values, size_t count, const float* dense );
+
+// Dot product of 2 sparse vectors. The indices must be sorted in ascending order without duplicates.
+// The scalar version merges the index lists, the other one compares blocks of 8 indices with AVX2 and requires AVX2 + FMA3.
+float sparseSparseDotProductScalar( const uint32_t* indices1, const float* values1, size_t count1, const uint32_t* indices2, const float* values2, size_t count2 );
+float sparseSparseDotProduct( const uint32_t* indices1, const float* values1, size_t count1, const uint32_t* indices2, const float* values2, size_t count2 );
+
+// Dot products of 2 vectors with each other and with themselves
+struct sDotProducts
+{
+	float ab, aa, bb;
+};
+
+// Compute a·b, a·a and b·b in a single pass over both vectors. Requires AVX2 + FMA3.
+sDotProducts fusedDotProducts( const float* p1, const float* p2, size_t count );
+
+// Cosine of the angle between the vectors, or 0 if any of them is zero. Requires AVX2 + FMA3.
+float cosineSimilarity( const float* p1, const float* p2, size_t count );
+
+// Euclidean distance between the vectors scaled to unit length, in [ 0 .. 2 ] interval. Requires AVX2 + FMA3.
+float normalizedL2Distance( const float* p1, const float* p2, size_t count );
+
+// Reductions over float arrays, built on the same multi-accumulator loop as avx_vertical_multi.
+// The template argument is count of independent accumulators, 1-4. Require AVX2 + FMA3.
+template<int accumulators = 4>
+float squaredL2Distance( const float* p1, const float* p2, size_t count );
+template<int accumulators = 4>
+float l1Distance( const float* p1, const float* p2, size_t count );
+template<int accumulators = 4>
+float sumFloats( const float* p, size_t count );
+// Minimum and maximum skip NaNs. For empty arrays they return +inf and -inf, respectively.
+template<int accumulators = 4>
+float minimum( const float* p, size_t count );
+template<int accumulators = 4>
+float maximum( const float* p, size_t count );
+// Index of the first maximum element, or 0 if there's none. The count must be less than 2^31.
+template<int accumulators = 4>
+size_t argmax( const float* p, size_t count );
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// 32-byte version of dpps instruction is from AVX, this source file is compiled for that instruction set.
+
+template<>
+float dotProduct<eDotProductAlgorithm::AvxDpPs>( const float* p1, const float* p2, size_t count )
+{
+	__m256 acc = _mm256_setzero_ps();
+	const float* const p1End = p1 + ( count - count % 8 );
+	for( ; p1 < p1End; p1 += 8, p2 += 8 )
+	{
+		// Load 2 vectors, 8 floats / each
+		const __m256 a = _mm256_loadu_ps( p1 );
+		const __m256 b = _mm256_loadu_ps( p2 );
+		// vdpps AVX instruction does not compute dot product of 8-wide vectors.
+		// Instead, that instruction computes 2 independent dot products of 4-wide vectors.
+		const __m256 dp = _mm256_dp_ps( a, b, 0xFF );
+		acc = _mm256_add_ps( acc, dp );
+	}
+
+	// The remaining 1-7 floats. Masked loads set unused lanes to zero, they don't change the dot product.
+	const size_t remainder = count % 8;
+	if( 0 != remainder )
+	{
+		const __m256i mask = remainderMask( remainder );
+		const __m256 a = _mm256_maskload_ps( p1, mask );
+		const __m256 b = _mm256_maskload_ps( p2, mask );
+		acc = _mm256_add_ps( acc, _mm256_dp_ps( a, b, 0xFF ) );
+	}
+
+	// Add the 2 results into a single float.
+	const __m128 low = _mm256_castps256_ps128( acc );	//< Compiles into no instructions. The low half of a YMM register is directly accessible as an XMM register with the same number.
+	const __m128 high = _mm256_extractf128_ps( acc, 1 );	//< This one however does need to move data, from high half of a register into low half. vextractf128 instruction does that.
+	const __m128 result = _mm_add_ss( low, high );
+	return _mm_cvtss_f32( result );
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "mappedFile.h"
+#include <functional>
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+constexpr int fileRepeats = 3;
+
+// Page faults of the process so far, or false if the OS doesn't report them
+static bool pageFaults( uint64_t& minor, uint64_t& major )
+{
+#ifdef __linux__
+	rusage usage;
+	if( 0 != getrusage( RUSAGE_SELF, &usage ) )
+		return false;
+	minor = (uint64_t)usage.ru_minflt;
+	major = (uint64_t)usage.ru_majflt;
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Measures time and page faults of a function
+class FaultsTimer
+{
+	uint64_t minor0 = 0, major0 = 0;
+	bool hasFaults;
+	const Stopwatch stopwatch;
+
+public:
+	FaultsTimer()
+	{
+		hasFaults = pageFaults( minor0, major0 );
+	}
+
+	// Print time, bandwidth and page faults since construction, return the time in microseconds
+	double print( const char* what, double bytes ) const
+	{
+		const double us = stopwatch.elapsedMicroseconds();
+		uint64_t minor, major;
+		printf( "%s: %g us, %.2f GB/s", what, us, bytes / us * 1E-3 );
+		if( hasFaults && pageFaults( minor, major ) )
+			printf( ", %i minor and %i major page faults\n", (int)( minor - minor0 ), (int)( major - major0 ) );
+		else
+			printf( "\n" );
+		return us;
+	}
+};
+
+static void printUsage()
+{
+	printf( "Usage: file <path> <algorithm> [options]: dot product of 2 halves of the raw float32 file, algorithm is the number or auto\n" );
+	printf( "   or: file <path> rows <length> [options]: dot products of all rows of the file with the first one\n" );
+	printf( "Options: populate for MAP_POPULATE, sequential for MADV_SEQUENTIAL, willneed for MADV_WILLNEED, cold to evict the file from the page cache first\n" );
+}
+
+int benchmarkFile( int argc, const char* argv[] )
+{
+	if( argc < 2 )
+	{
+		printUsage();
+		return 2;
+	}
+
+	// Parse the arguments
+	const char* const path = argv[ 0 ];
+	bool rows = false;
+	int algoInt = (int)fastestAlgorithm();
+	int rowLength = 0;
+	int nextArg = 2;
+	if( 0 == strcmp( argv[ 1 ], "rows" ) )
+	{
+		rows = true;
+		if( argc < 3 || !nonstd::atoi( argv[ 2 ], rowLength ) || rowLength <= 0 )
+		{
+			printUsage();
+			return 2;
+		}
+		nextArg = 3;
+		if( !isSupported( eInstructionSet::Avx2 ) )
+		{
+			printf( "matrixVectorProduct requires %s\n", instructionSetName( eInstructionSet::Avx2 ) );
+			return 3;
+		}
+	}
+	else if( 0 != strcmp( argv[ 1 ], "auto" ) && ( !nonstd::atoi( argv[ 1 ], algoInt ) || algoInt < 0 || algoInt >= (int)eDotProductAlgorithm::valuesCount ) )
+	{
+		printUsage();
+		return 2;
+	}
+	const eDotProductAlgorithm algo = (eDotProductAlgorithm)algoInt;
+	if( !rows && !isSupported( requiredInstructionSet( algo ) ) )
+	{
+		printf( "%s requires %s\n", algorithmName( algo ), instructionSetName( requiredInstructionSet( algo ) ) );
+		return 3;
+	}
+
+	MappedFile::sOptions options;
+	for( int i = nextArg; i < argc; i++ )
+	{
+		if( 0 == strcmp( argv[ i ], "populate" ) )
+			options.populate = true;
+		else if( 0 == strcmp( argv[ i ], "sequential" ) )
+			options.sequential = true;
+		else if( 0 == strcmp( argv[ i ], "willneed" ) )
+			options.willNeed = true;
+		else if( 0 == strcmp( argv[ i ], "cold" ) )
+			options.dropCache = true;
+		else
+		{
+			printf( "Unknown option \"%s\"\n", argv[ i ] );
+			printUsage();
+			return 2;
+		}
+	}
+
+	// Map the file. With populate option, this is where the file is read and the pages are mapped.
+	const FaultsTimer mapTimer;
+	const MappedFile file{ path, options };
+	if( !file.valid() )
+	{
+		printf( "Unable to map the file \"%s\": %s\n", path, strerror( file.errorCode() ) );
+		return 4;
+	}
+	const double bytes = (double)file.bytes();
+	mapTimer.print( "mmap", bytes );
+
+	const float* const data = file.floats();
+	const size_t count = file.bytes() / sizeof( float );
+	std::function<void()> compute;
+	std::vector<float> scores;
+	float result = 0;
+	if( rows )
+	{
+		// The first row of the mapping is the query
+		const size_t rowsCount = count / (size_t)rowLength;
+		if( 0 == rowsCount )
+		{
+			printf( "The file is shorter than a row\n" );
+			return 2;
+		}
+		scores.resize( rowsCount );
+		compute = [ =, &scores, &result ]()
+		{
+			matrixVectorProduct( data, rowsCount, data, (size_t)rowLength, scores.data() );
+			result = *std::max_element( scores.begin(), scores.end() );
+		};
+		printf( "%i rows * %i floats, %s\n", (int)rowsCount, rowLength, "matrixVectorProduct" );
+	}
+	else
+	{
+		const size_t half = count / 2;
+		const pfnDotProduct pfn = dotProductFunc( algo );
+		compute = [ =, &result ]() { result = pfn( data, data + half, half ); };
+		printf( "2 vectors * %i floats, %s\n", (int)half, algorithmName( algo ) );
+	}
+
+	// The first pass touches the pages for the first time, unless they were populated. The page faults, and maybe disk reads, happen here.
+	const FaultsTimer firstTimer;
+	compute();
+	const double usFirst = firstTimer.print( "First pass", bytes );
+
+	// Then the pages are mapped, the time is spent on compute and memory bandwidth
+	const FaultsTimer residentTimer;
+	for( int i = 0; i < fileRepeats; i++ )
+		compute();
+	const double usResident = residentTimer.print( "Resident pages", bytes * fileRepeats ) / fileRepeats;
+
+	const double usFaults = std::max( usFirst - usResident, 0.0 );
+	printf( "Page faults and I/O of the first pass: %g us, %.0f%%; compute: %g us, %.0f%%\n", usFaults, 100.0 * usFaults / usFirst, usResident, 100.0 * ( usFirst - usFaults ) / usFirst );
+	printf( "Result: %g\n", (double)result );
+	return 0;
+}
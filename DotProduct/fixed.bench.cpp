@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// 1024 pairs of vectors, up to 512kb for 64 floats, they stay in L2 cache. The benchmark makes 4M dot products of them.
+constexpr size_t fixedDefaultCalls = 4 * 1024 * 1024;
+constexpr int fixedRepeats = 5;
+
+static volatile float s_sink;
+
+// Time in microseconds of the measurement loop
+template<class TFunc>
+static double measureLoop( TFunc func )
+{
+	return bestTime( fixedRepeats, [ & ]() { s_sink = func(); } );
+}
+
+// Time in microseconds of many calls of the non-inlined dotProduct<AvxVerticalFma4>, same loop as in fixed.cpp
+static double measureCalls( const float* p1, const float* p2, size_t length, size_t calls, bool dependent )
+{
+	return measureLoop( [ & ]()
+	{
+		float sum = 0;
+		float prev = 0;
+		for( size_t i = 0; i < calls; i++ )
+		{
+			size_t offset = ( i % fixedPairs ) * length;
+			if( dependent )
+				offset += ( prev < 0 ) ? length : 0;
+			prev = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( p1 + offset, p2 + offset, length );
+			sum += prev;
+		}
+		return sum;
+	} );
+}
+
+template<size_t length>
+static void benchmarkLength( const float* p1, const float* p2, size_t calls )
+{
+	double usFixed[ 2 ], usRuntime[ 2 ], usCall[ 2 ];
+	for( int dependent = 0; dependent < 2; dependent++ )
+	{
+		usFixed[ dependent ] = measureLoop( [ & ]() { return fixedLengthLoop<length>( p1, p2, calls, 0 != dependent ); } );
+		usRuntime[ dependent ] = measureLoop( [ & ]() { return runtimeLengthLoop( p1, p2, length, calls, 0 != dependent ); } );
+		usCall[ dependent ] = measureCalls( p1, p2, length, calls, 0 != dependent );
+	}
+
+	float maxDifference = 0;
+	for( size_t i = 0; i < fixedPairs; i++ )
+	{
+		const float* a = p1 + i * length;
+		const float* b = p2 + i * length;
+		const float fixed = dotProductFixed<length>( a, b );
+		const float runtime = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( a, b, length );
+		maxDifference = std::max( maxDifference, std::abs( fixed - runtime ) / std::abs( runtime ) );
+	}
+
+	const double ns = 1E3 / (double)calls;
+	printf( "%i floats, maximum relative difference from AvxVerticalFma4 %g\n", (int)length, (double)maxDifference );
+	const char* const modes[ 2 ] = { "independent", "latency" };
+	for( int i = 0; i < 2; i++ )
+	{
+		printf( "  %s: avx_vertical_fixed inlined %.2f ns; avx_vertical_multi<4> inlined, runtime length %.2f ns, %.2fx; AvxVerticalFma4 call %.2f ns, %.2fx\n",
+			modes[ i ], usFixed[ i ] * ns, usRuntime[ i ] * ns, usRuntime[ i ] / usFixed[ i ], usCall[ i ] * ns, usCall[ i ] / usFixed[ i ] );
+	}
+}
+
+// The optional argument is count of dot products to compute for each length
+int benchmarkFixed( int argc, const char* argv[] )
+{
+	size_t calls = fixedDefaultCalls;
+	if( !parseLength( argc, argv, calls ) )
+		return 2;
+
+	constexpr size_t maxLength = 64;
+	auto p1 = alignedArray<float>( fixedPairs * maxLength );
+	auto p2 = alignedArray<float>( fixedPairs * maxLength );
+	fillRandomVector( true, p1.get(), fixedPairs * maxLength, 11 );
+	fillRandomVector( true, p2.get(), fixedPairs * maxLength, 12 );
+
+	printf( "Time per dot product, %i calls for every length\n", (int)calls );
+	benchmarkLength<16>( p1.get(), p2.get(), calls );
+	benchmarkLength<32>( p1.get(), p2.get(), calls );
+	benchmarkLength<64>( p1.get(), p2.get(), calls );
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "vertical.hpp"
+// Measurement loops of the fixed benchmark, this source file is compiled for AVX2 + FMA3.
+// The kernels are inlined into the loops, with the length known at compile time the dot product is fully unrolled.
+
+namespace
+{
+	// Sum of many dot products of the pairs of vectors, cycling through the pairs.
+	// With dependent = true, the address of every pair depends on the previous result; the inputs are non-negative, the extra offset is always zero but the compiler doesn't know that.
+	template<bool dependent, class TFunc>
+	__forceinline float fixedLoop( const float* p1, const float* p2, size_t length, size_t calls, TFunc func )
+	{
+		float sum = 0;
+		float prev = 0;
+		for( size_t i = 0; i < calls; i++ )
+		{
+			size_t offset = ( i % fixedPairs ) * length;
+			if constexpr( dependent )
+				offset += ( prev < 0 ) ? length : 0;
+			prev = func( p1 + offset, p2 + offset );
+			sum += prev;
+		}
+		return sum;
+	}
+}
+
+template<size_t length>
+float fixedLengthLoop( const float* p1, const float* p2, size_t calls, bool dependent )
+{
+	auto func = []( const float* a, const float* b ) { return avx_vertical_fixed<length>( a, b ); };
+	if( dependent )
+		return fixedLoop<true>( p1, p2, length, calls, func );
+	return fixedLoop<false>( p1, p2, length, calls, func );
+}
+
+template float fixedLengthLoop<16>( const float* p1, const float* p2, size_t calls, bool dependent );
+template float fixedLengthLoop<32>( const float* p1, const float* p2, size_t calls, bool dependent );
+template float fixedLengthLoop<64>( const float* p1, const float* p2, size_t calls, bool dependent );
+
+float runtimeLengthLoop( const float* p1, const float* p2, size_t length, size_t calls, bool dependent )
+{
+	// The length is a function argument, the compiler can't unroll the kernel for it
+	auto func = [ length ]( const float* a, const float* b ) { return avx_vertical_multi<4>( a, b, length ); };
+	if( dependent )
+		return fixedLoop<true>( p1, p2, length, calls, func );
+	return fixedLoop<false>( p1, p2, length, calls, func );
+}
@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+static const size_t s_gemmSizes[] = { 64, 128, 256, 512 };
+constexpr int gemmRepeats = 5;
+
+// Textbook version: a dot product of every row of A with every column of B, accumulated in double for the reference
+static void naiveMatrixProduct( const float* a, const float* b, double* c, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+		for( size_t j = 0; j < n; j++ )
+		{
+			double sum = 0;
+			for( size_t k = 0; k < n; k++ )
+				sum += (double)a[ i * n + k ] * (double)b[ k * n + j ];
+			c[ i * n + j ] = sum;
+		}
+}
+
+// GFLOP/s of AvxVerticalFma4 with both vectors in L1D cache. Dot products are limited by loads, 2 of them per FMA, so this is about half of the FMA peak.
+static double dotProductGflops()
+{
+	constexpr size_t length = 2048;
+	constexpr int iterations = 1000;
+	auto p1 = alignedArray<float>( length );
+	auto p2 = alignedArray<float>( length );
+	fillRandomVector( true, p1.get(), length, 11 );
+	fillRandomVector( true, p2.get(), length, 12 );
+	volatile float sink;
+	const double us = bestTime( gemmRepeats, [ & ]()
+	{
+		float sum = 0;
+		for( int i = 0; i < iterations; i++ )
+			sum += dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( p1.get(), p2.get(), length );
+		sink = sum;
+	} );
+	return 2.0 * length * iterations / us * 1E-3;
+}
+
+// The optional argument is size of the square matrices, by default the benchmark runs several sizes
+int benchmarkGemm( int argc, const char* argv[] )
+{
+	std::vector<size_t> sizes{ std::begin( s_gemmSizes ), std::end( s_gemmSizes ) };
+	if( argc > 0 )
+	{
+		size_t n;
+		if( !parseLength( argc, argv, n ) )
+			return 2;
+		sizes = { n };
+	}
+
+	const double dotGflops = dotProductGflops();
+	printf( "AvxVerticalFma4 in L1D cache: %.1f GFLOP/s\n", dotGflops );
+
+	int exitCode = 0;
+	for( size_t n : sizes )
+	{
+		auto a = alignedArray<float>( n * n );
+		auto b = alignedArray<float>( n * n );
+		auto c = alignedArray<float>( n * n );
+		std::vector<double> reference( n * n );
+		fillRandomVector( true, a.get(), n * n, 11 );
+		fillRandomVector( true, b.get(), n * n, 12 );
+
+		const double usNaive = bestTime( 1, [ & ]() { naiveMatrixProduct( a.get(), b.get(), reference.data(), n ); } );
+		const double usGemm = bestTime( gemmRepeats, [ & ]() { matrixProduct( a.get(), b.get(), c.get(), n, n, n ); } );
+
+		// All inputs are non-negative, the relative error is well-defined
+		double maxError = 0;
+		for( size_t i = 0; i < n * n; i++ )
+			maxError = std::max( maxError, std::abs( (double)c[ i ] - reference[ i ] ) / reference[ i ] );
+
+		const double flops = 2.0 * (double)n * (double)n * (double)n;
+		const double gflops = flops / usGemm * 1E-3;
+		printf( "%i x %i: naive %g us, matrixProduct %g us, %.2fx faster; %.1f GFLOP/s, %.2f of AvxVerticalFma4; maximum relative error %g\n",
+			(int)n, (int)n, usNaive, usGemm, usNaive / usGemm, gflops, gflops / dotGflops, maxError );
+		if( maxError > 1E-5 )
+		{
+			printf( "Error: the result is too far from the reference\n" );
+			exitCode = 1;
+		}
+	}
+	return exitCode;
+}
@@ -0,0 +1,136 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Matrix multiplication with a register-tiled micro-kernel, this source file is compiled for AVX2 + FMA3.
+
+// The micro-kernel computes 6 rows * 16 columns of the output in 12 accumulator registers.
+// Every iteration loads 2 vectors of B and broadcasts 6 floats of A, for 12 independent FMAs; that's enough to hide their latency on 2 FMA ports.
+constexpr size_t gemmRows = 6;
+constexpr size_t gemmColumns = 16;
+// Cache blocking: a 6 * kc sliver of packed A and kc * 16 sliver of packed B fit in L1D, the packed block of A in L2
+constexpr size_t gemmBlockK = 256;
+constexpr size_t gemmBlockM = 72;
+
+// Copy the block of B into slivers of 16 columns, each of them stores `depth` rows sequentially. The columns past the end are zeros.
+static void packB( const float* b, size_t ldb, size_t depth, size_t columns, float* dst )
+{
+	for( size_t j = 0; j < columns; j += gemmColumns )
+	{
+		const size_t width = std::min( columns - j, gemmColumns );
+		const float* src = b + j;
+		if( width == gemmColumns )
+		{
+			for( size_t k = 0; k < depth; k++, src += ldb, dst += gemmColumns )
+			{
+				_mm256_store_ps( dst, _mm256_loadu_ps( src ) );
+				_mm256_store_ps( dst + 8, _mm256_loadu_ps( src + 8 ) );
+			}
+		}
+		else
+		{
+			const __m256i mask0 = remainderMask( std::min( width, (size_t)8 ) );
+			const __m256i mask1 = remainderMask( width > 8 ? width - 8 : 0 );
+			for( size_t k = 0; k < depth; k++, src += ldb, dst += gemmColumns )
+			{
+				_mm256_store_ps( dst, _mm256_maskload_ps( src, mask0 ) );
+				_mm256_store_ps( dst + 8, _mm256_maskload_ps( src + 8, mask1 ) );
+			}
+		}
+	}
+}
+
+// Copy the block of A into slivers of 6 rows, each of them stores `depth` columns interleaved, 6 floats per column. The rows past the end are zeros.
+static void packA( const float* a, size_t lda, size_t rows, size_t depth, float* dst )
+{
+	for( size_t i = 0; i < rows; i += gemmRows )
+	{
+		const size_t height = std::min( rows - i, gemmRows );
+		const float* const src = a + i * lda;
+		for( size_t k = 0; k < depth; k++, dst += gemmRows )
+		{
+			size_t r = 0;
+			for( ; r < height; r++ )
+				dst[ r ] = src[ r * lda + k ];
+			for( ; r < gemmRows; r++ )
+				dst[ r ] = 0;
+		}
+	}
+}
+
+// Multiply 6 * depth sliver of packed A by depth * 16 sliver of packed B, add the product to the 6x16 tile of C
+__forceinline void microKernel( const float* pa, const float* pb, size_t depth, float* c, size_t ldc, size_t rows, size_t columns )
+{
+	// 12 accumulators, with 2 vectors of B and the broadcasted element of A the loop uses 15 of 16 ymm registers
+	__m256 acc0[ gemmRows ], acc1[ gemmRows ];
+	for( size_t r = 0; r < gemmRows; r++ )
+		acc0[ r ] = acc1[ r ] = _mm256_setzero_ps();
+
+	for( size_t k = 0; k < depth; k++, pa += gemmRows, pb += gemmColumns )
+	{
+		const __m256 b0 = _mm256_load_ps( pb );
+		const __m256 b1 = _mm256_load_ps( pb + 8 );
+		for( size_t r = 0; r < gemmRows; r++ )
+		{
+			const __m256 a = _mm256_broadcast_ss( pa + r );
+			acc0[ r ] = fmadd_ps<true>( a, b0, acc0[ r ] );
+			acc1[ r ] = fmadd_ps<true>( a, b1, acc1[ r ] );
+		}
+	}
+
+	if( rows == gemmRows && columns == gemmColumns )
+	{
+		for( size_t r = 0; r < gemmRows; r++, c += ldc )
+		{
+			_mm256_storeu_ps( c, _mm256_add_ps( _mm256_loadu_ps( c ), acc0[ r ] ) );
+			_mm256_storeu_ps( c + 8, _mm256_add_ps( _mm256_loadu_ps( c + 8 ), acc1[ r ] ) );
+		}
+		return;
+	}
+
+	// Incomplete tile on the bottom or right edge of the matrix. Indexing the accumulators with a runtime count of rows would spill them to memory in the main loop, storing them to a temporary tile instead.
+	alignas( 32 ) float tile[ gemmRows ][ gemmColumns ];
+	for( size_t r = 0; r < gemmRows; r++ )
+	{
+		_mm256_store_ps( tile[ r ], acc0[ r ] );
+		_mm256_store_ps( tile[ r ] + 8, acc1[ r ] );
+	}
+	for( size_t r = 0; r < rows; r++, c += ldc )
+		for( size_t j = 0; j < columns; j++ )
+			c[ j ] += tile[ r ][ j ];
+}
+
+void matrixProduct( const float* a, const float* b, float* c, size_t m, size_t n, size_t k )
+{
+	for( size_t i = 0; i < m; i++ )
+		std::fill_n( c + i * n, n, 0.0f );
+	if( 0 == m || 0 == n || 0 == k )
+		return;
+
+	// The packed blocks are reused for all of the tiles they're multiplied by
+	const size_t nPadded = ( n + gemmColumns - 1 ) / gemmColumns * gemmColumns;
+	const size_t kBlock = std::min( k, gemmBlockK );
+	auto packedB = alignedArray<float>( kBlock * nPadded );
+	auto packedA = alignedArray<float>( gemmBlockM * kBlock );
+
+	for( size_t pc = 0; pc < k; pc += gemmBlockK )
+	{
+		const size_t depth = std::min( k - pc, gemmBlockK );
+		packB( b + pc * n, n, depth, n, packedB.get() );
+
+		for( size_t ic = 0; ic < m; ic += gemmBlockM )
+		{
+			const size_t rows = std::min( m - ic, gemmBlockM );
+			packA( a + ic * k + pc, k, rows, depth, packedA.get() );
+
+			for( size_t jr = 0; jr < n; jr += gemmColumns )
+			{
+				const float* const pb = packedB.get() + jr * depth;
+				for( size_t ir = 0; ir < rows; ir += gemmRows )
+				{
+					const float* const pa = packedA.get() + ir * depth;
+					microKernel( pa, pb, depth, c + ( ic + ir ) * n + jr, n, std::min( rows - ir, gemmRows ), std::min( n - jr, gemmColumns ) );
+				}
+			}
+		}
+	}
+}
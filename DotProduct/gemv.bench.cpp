@@ -0,0 +1,70 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// Default sizes: rows * floats. The first ones fit in L1D or L2 cache, where reloading the vector for every row costs throughput.
+// The last one is 4MB and doesn't fit in L2 cache of most CPUs, both versions are limited by memory bandwidth.
+static const std::array<std::pair<size_t, size_t>, 4> s_gemvSizes =
+{ {
+	{ 64, 128 },
+	{ 256, 128 },
+	{ 256, 256 },
+	{ 2048, 512 },
+} };
+// Every measurement processes at least this count of floats, small matrices are multiplied many times
+constexpr size_t gemvMinFloats = 4 * 1024 * 1024;
+// Both versions are measured several times, the benchmark prints the fastest time.
+constexpr int gemvRepeats = 10;
+
+static void measureGemv( size_t rows, size_t length )
+{
+	auto matrix = alignedArray<float>( rows * length );
+	auto vec = alignedArray<float>( length );
+	fillRandomVector( true, matrix.get(), rows * length, 11 );
+	fillRandomVector( true, vec.get(), length, 12 );
+	std::vector<float> resultLoop( rows ), resultBatch( rows );
+	const size_t calls = std::max( gemvMinFloats / ( rows * length ), (size_t)1 );
+
+	const double usLoop = bestTime( gemvRepeats, [ & ]()
+	{
+		for( size_t c = 0; c < calls; c++ )
+		{
+			const float* row = matrix.get();
+			for( size_t i = 0; i < rows; i++, row += length )
+				resultLoop[ i ] = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( row, vec.get(), length );
+		}
+	} ) / (double)calls;
+	const double usBatch = bestTime( gemvRepeats, [ & ]()
+	{
+		for( size_t c = 0; c < calls; c++ )
+			matrixVectorProduct( matrix.get(), rows, vec.get(), length, resultBatch.data() );
+	} ) / (double)calls;
+
+	// Different order of additions, the results are slightly different
+	double maxError = 0;
+	for( size_t i = 0; i < rows; i++ )
+		maxError = std::max( maxError, std::abs( (double)resultLoop[ i ] - (double)resultBatch[ i ] ) / std::abs( (double)resultLoop[ i ] ) );
+
+	// Both versions read the complete matrix once per call, the vector stays in L1D cache
+	const double matrixBytes = (double)( rows * length * sizeof( float ) );
+	printf( "%i rows * %i floats, %i KB\n", (int)rows, (int)length, (int)( rows * length * sizeof( float ) / 1024 ) );
+	printf( "\tLoop over AvxVerticalFma4: %g us, %.1f GB/s\n", usLoop, matrixBytes / usLoop * 1E-3 );
+	printf( "\tmatrixVectorProduct: %g us, %.1f GB/s, %.2fx faster\n", usBatch, matrixBytes / usBatch * 1E-3, usLoop / usBatch );
+	printf( "\tMaximum relative difference of the results: %g\n", maxError );
+}
+
+// The optional arguments are count of rows, and length of the rows
+int benchmarkGemv( int argc, const char* argv[] )
+{
+	if( argc < 1 )
+	{
+		for( const auto& size : s_gemvSizes )
+			measureGemv( size.first, size.second );
+		return 0;
+	}
+
+	size_t rows = 0, length = 256;
+	if( !parseLength( argc, argv, rows ) || !parseLength( argc - 1, argv + 1, length ) )
+		return 2;
+	measureGemv( rows, length );
+	return 0;
+}
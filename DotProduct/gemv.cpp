@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Batched dot products of one vector with many rows of a matrix. This source file is compiled for AVX2 + FMA3.
+
+// Horizontal sums of 4 vectors, returned in the 4 lanes of the result
+__forceinline __m128 hadd4_ps( __m256 a, __m256 b, __m256 c, __m256 d )
+{
+	// vhaddps adds adjacent pairs of lanes, independently within 16-byte halves of the registers
+	const __m256 ab = _mm256_hadd_ps( a, b );
+	const __m256 cd = _mm256_hadd_ps( c, d );
+	// Now each 16-byte half of abcd has partial sums of a, b, c and d, in that order
+	const __m256 abcd = _mm256_hadd_ps( ab, cd );
+	const __m128 low = _mm256_castps256_ps128( abcd );
+	const __m128 high = _mm256_extractf128_ps( abcd, 1 );
+	return _mm_add_ps( low, high );
+}
+
+// Compute dot products of the vector with the block of sequential rows of the matrix.
+// Every load of the vector feeds `rowsBlock` rows, and each row has 2 independent accumulators to hide the latency of FMA.
+template<int rowsBlock>
+__forceinline void gemvBlock( const float* rows, const float* vec, size_t count, float* result )
+{
+	static_assert( rowsBlock > 0 && rowsBlock <= 4 );
+	const float* const vecEnd = vec + ( count - count % 16 );
+
+	__m256 dot0[ rowsBlock ], dot1[ rowsBlock ];
+	for( int r = 0; r < rowsBlock; r++ )
+	{
+		dot0[ r ] = _mm256_setzero_ps();
+		dot1[ r ] = _mm256_setzero_ps();
+	}
+
+	for( ; vec < vecEnd; vec += 16, rows += 16 )
+	{
+		// Load 16 floats of the vector once, use them for all rows of the block.
+		const __m256 v0 = _mm256_loadu_ps( vec );
+		const __m256 v1 = _mm256_loadu_ps( vec + 8 );
+		for( int r = 0; r < rowsBlock; r++ )
+		{
+			const float* const row = rows + r * count;
+			dot0[ r ] = fmadd_ps<true>( _mm256_loadu_ps( row ), v0, dot0[ r ] );
+			dot1[ r ] = fmadd_ps<true>( _mm256_loadu_ps( row + 8 ), v1, dot1[ r ] );
+		}
+	}
+
+	// The remaining 0-15 floats: maybe a complete vector, then a masked load
+	size_t remainder = count % 16;
+	if( remainder >= 8 )
+	{
+		const __m256 v = _mm256_loadu_ps( vec );
+		for( int r = 0; r < rowsBlock; r++ )
+			dot0[ r ] = fmadd_ps<true>( _mm256_loadu_ps( rows + r * count ), v, dot0[ r ] );
+		vec += 8;
+		rows += 8;
+		remainder -= 8;
+	}
+	if( remainder > 0 )
+	{
+		const __m256i mask = remainderMask( remainder );
+		const __m256 v = _mm256_maskload_ps( vec, mask );
+		for( int r = 0; r < rowsBlock; r++ )
+			dot1[ r ] = fmadd_ps<true>( _mm256_maskload_ps( rows + r * count, mask ), v, dot1[ r ] );
+	}
+
+	for( int r = 0; r < rowsBlock; r++ )
+		dot0[ r ] = _mm256_add_ps( dot0[ r ], dot1[ r ] );
+
+	if constexpr( rowsBlock == 4 )
+	{
+		// Reduce all 4 rows at once, and store the results with a single instruction.
+		const __m128 sums = hadd4_ps( dot0[ 0 ], dot0[ 1 ], dot0[ 2 ], dot0[ 3 ] );
+		_mm_storeu_ps( result, sums );
+	}
+	else
+	{
+		for( int r = 0; r < rowsBlock; r++ )
+			result[ r ] = hadd_ps( dot0[ r ] );
+	}
+}
+
+void matrixVectorProduct( const float* matrix, size_t rows, const float* vec, size_t count, float* result )
+{
+	const size_t blockStride = 4 * count;
+	for( size_t i = rows / 4; i > 0; i--, matrix += blockStride, result += 4 )
+		gemvBlock<4>( matrix, vec, count, result );
+
+	// The remaining 1-3 rows
+	switch( rows % 4 )
+	{
+	case 1:
+		gemvBlock<1>( matrix, vec, count, result );
+		return;
+	case 2:
+		gemvBlock<2>( matrix, vec, count, result );
+		return;
+	case 3:
+		gemvBlock<3>( matrix, vec, count, result );
+		return;
+	}
+}
@@ -0,0 +1,48 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// 8M floats = 32MB per vector, way larger than caches. Half precision copies are 16MB each.
+constexpr size_t halfDefaultLength = 8 * 1024 * 1024;
+constexpr int halfRepeats = 10;
+
+// The optional argument is length of the vectors
+int benchmarkHalf( int argc, const char* argv[] )
+{
+	size_t count = halfDefaultLength;
+	if( !parseLength( argc, argv, count ) )
+		return 2;
+
+	auto v1 = alignedArray<float>( count );
+	auto v2 = alignedArray<float>( count );
+	fillRandomVector( true, v1.get(), count, 11 );
+	fillRandomVector( true, v2.get(), count, 12 );
+	const long double reference = referenceDotProduct( v1.get(), v2.get(), count );
+
+	float result = 0;
+	const double usFloat = bestTime( halfRepeats, [ & ]()
+	{
+		result = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( v1.get(), v2.get(), count );
+	} );
+	printf( "%i values\n", (int)count );
+	printResult( "fp32 AvxVerticalFma4", usFloat, (double)( count * 8 ), result, reference, usFloat );
+
+	auto h1 = alignedArray<uint16_t>( count );
+	auto h2 = alignedArray<uint16_t>( count );
+	const std::pair<eHalfFormat, const char*> formats[] =
+	{
+		{ eHalfFormat::Fp16, "fp16" },
+		{ eHalfFormat::Bf16, "bf16" },
+	};
+	for( const auto& f : formats )
+	{
+		// The relative error includes the rounding of the inputs, for bf16 it's much larger than the error of the summation
+		convertToHalf( f.first, v1.get(), h1.get(), count );
+		convertToHalf( f.first, v2.get(), h2.get(), count );
+		const double us = bestTime( halfRepeats, [ & ]()
+		{
+			result = dotProductHalf( f.first, h1.get(), h2.get(), count );
+		} );
+		printResult( f.second, us, (double)( count * 4 ), result, reference, usFloat );
+	}
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// 16-bit inputs. This source file is compiled for AVX2 + FMA3 + F16C.
+// Out of cache, the dot product is bound by memory bandwidth. These versions read half the bytes, the conversion to fp32 is cheap compared to RAM loads.
+
+// Load 8 values, convert to fp32
+template<eHalfFormat format>
+__forceinline __m256 loadHalf( const uint16_t* p )
+{
+	const __m128i src = _mm_loadu_si128( ( const __m128i* )p );
+	if constexpr( format == eHalfFormat::Fp16 )
+		return _mm256_cvtph_ps( src );
+	else
+	{
+		// bfloat16 is the upper half of fp32, zero-extend to 32 bits and shift left
+		const __m256i i32 = _mm256_cvtepu16_epi32( src );
+		return _mm256_castsi256_ps( _mm256_slli_epi32( i32, 16 ) );
+	}
+}
+
+// Load 1-7 values, the rest of the lanes are zeros.
+// There's no masked load for 16-bit lanes, copying to a local buffer is good enough for the last few values.
+template<eHalfFormat format>
+__forceinline __m256 loadHalfPartial( const uint16_t* p, size_t count )
+{
+	alignas( 16 ) uint16_t buffer[ 8 ] = {};
+	memcpy( buffer, p, count * 2 );
+	return loadHalf<format>( buffer );
+}
+
+// Same structure as avx_vertical_multi<4>, with different loads
+template<eHalfFormat format>
+__forceinline float avx_vertical_half( const uint16_t* p1, const uint16_t* p2, size_t count )
+{
+	constexpr int valuesPerLoop = 32;
+	const size_t remainder = count % valuesPerLoop;
+	const uint16_t* const p1End = p1 + ( count - remainder );
+
+	__m256 dot0 = _mm256_setzero_ps();
+	__m256 dot1 = _mm256_setzero_ps();
+	__m256 dot2 = _mm256_setzero_ps();
+	__m256 dot3 = _mm256_setzero_ps();
+	for( ; p1 < p1End; p1 += valuesPerLoop, p2 += valuesPerLoop )
+	{
+		dot0 = _mm256_fmadd_ps( loadHalf<format>( p1 ), loadHalf<format>( p2 ), dot0 );
+		dot1 = _mm256_fmadd_ps( loadHalf<format>( p1 + 8 ), loadHalf<format>( p2 + 8 ), dot1 );
+		dot2 = _mm256_fmadd_ps( loadHalf<format>( p1 + 16 ), loadHalf<format>( p2 + 16 ), dot2 );
+		dot3 = _mm256_fmadd_ps( loadHalf<format>( p1 + 24 ), loadHalf<format>( p2 + 24 ), dot3 );
+	}
+
+	// Up to 3 remaining complete vectors, then 1-7 remaining values
+	const size_t remainingVectors = remainder / 8;
+	if( remainingVectors > 0 )
+		dot0 = _mm256_fmadd_ps( loadHalf<format>( p1 ), loadHalf<format>( p2 ), dot0 );
+	if( remainingVectors > 1 )
+		dot1 = _mm256_fmadd_ps( loadHalf<format>( p1 + 8 ), loadHalf<format>( p2 + 8 ), dot1 );
+	if( remainingVectors > 2 )
+		dot2 = _mm256_fmadd_ps( loadHalf<format>( p1 + 16 ), loadHalf<format>( p2 + 16 ), dot2 );
+	const size_t remainingValues = remainder % 8;
+	if( remainingValues > 0 )
+	{
+		p1 += remainingVectors * 8;
+		p2 += remainingVectors * 8;
+		dot3 = _mm256_fmadd_ps( loadHalfPartial<format>( p1, remainingValues ), loadHalfPartial<format>( p2, remainingValues ), dot3 );
+	}
+
+	const __m256 dot01 = _mm256_add_ps( dot0, dot1 );
+	const __m256 dot23 = _mm256_add_ps( dot2, dot3 );
+	return hadd_ps( _mm256_add_ps( dot01, dot23 ) );
+}
+
+float dotProductHalf( eHalfFormat format, const uint16_t* p1, const uint16_t* p2, size_t count )
+{
+	if( format == eHalfFormat::Fp16 )
+		return avx_vertical_half<eHalfFormat::Fp16>( p1, p2, count );
+	return avx_vertical_half<eHalfFormat::Bf16>( p1, p2, count );
+}
+
+// Convert 8 floats to the 16-bit format
+template<eHalfFormat format>
+__forceinline __m128i storeHalf( __m256 v )
+{
+	if constexpr( format == eHalfFormat::Fp16 )
+		return _mm256_cvtps_ph( v, _MM_FROUND_TO_NEAREST_INT );
+	else
+	{
+		// Round to nearest even: add 0x7FFF plus the lowest bit of the result, then drop the lower 16 bits.
+		// The random vectors don't contain NaNs, they would need special handling.
+		__m256i i = _mm256_castps_si256( v );
+		const __m256i odd = _mm256_and_si256( _mm256_srli_epi32( i, 16 ), _mm256_set1_epi32( 1 ) );
+		i = _mm256_add_epi32( i, _mm256_add_epi32( odd, _mm256_set1_epi32( 0x7FFF ) ) );
+		i = _mm256_srli_epi32( i, 16 );
+		// Pack 32-bit lanes to 16 bits. The pack instruction works within 128-bit lanes, the permute fixes the order.
+		i = _mm256_packus_epi32( i, i );
+		i = _mm256_permute4x64_epi64( i, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		return _mm256_castsi256_si128( i );
+	}
+}
+
+template<eHalfFormat format>
+static void convertToHalfImpl( const float* src, uint16_t* dst, size_t count )
+{
+	const float* const srcEndAligned = src + ( count - count % 8 );
+	for( ; src < srcEndAligned; src += 8, dst += 8 )
+		_mm_storeu_si128( ( __m128i* )dst, storeHalf<format>( _mm256_loadu_ps( src ) ) );
+
+	const size_t remainder = count % 8;
+	if( 0 == remainder )
+		return;
+	alignas( 16 ) uint16_t buffer[ 8 ];
+	_mm_store_si128( ( __m128i* )buffer, storeHalf<format>( _mm256_maskload_ps( src, remainderMask( remainder ) ) ) );
+	memcpy( dst, buffer, remainder * 2 );
+}
+
+void convertToHalf( eHalfFormat format, const float* src, uint16_t* dst, size_t count )
+{
+	if( format == eHalfFormat::Fp16 )
+		convertToHalfImpl<eHalfFormat::Fp16>( src, dst, count );
+	else
+		convertToHalfImpl<eHalfFormat::Bf16>( src, dst, count );
+}
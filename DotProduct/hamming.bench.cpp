@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "hamming.h"
+
+// 1M binary vectors, the database takes 32MB for 256 bits, up to 128MB for 1024 bits
+constexpr size_t hammingDefaultRows = 1024 * 1024;
+constexpr size_t hammingK = 10;
+constexpr int hammingRepeats = 5;
+static const size_t s_hammingBits[] = { 256, 512, 1024 };
+
+// Prevents the compiler from dropping the computations of the single-pair loops
+static volatile uint64_t s_sink;
+
+// The optional argument is count of vectors in the database
+int benchmarkHamming( int argc, const char* argv[] )
+{
+	size_t rows = hammingDefaultRows;
+	if( !parseLength( argc, argv, rows ) )
+		return 2;
+
+	int exitCode = 0;
+	for( size_t bits : s_hammingBits )
+	{
+		const size_t words = bits / 64;
+		auto database = alignedArray<uint64_t>( rows * words );
+		auto query = alignedArray<uint64_t>( words );
+		std::mt19937_64 rng{ 11 };
+		std::generate( database.get(), database.get() + rows * words, std::ref( rng ) );
+		std::generate( query.get(), query.get() + words, std::ref( rng ) );
+		const uint64_t* const q = query.get();
+		const uint64_t* const db = database.get();
+
+		uint64_t sumScalar = 0, sumAvx = 0;
+		const double usPairScalar = bestTime( hammingRepeats, [ & ]
+		{
+			uint64_t sum = 0;
+			for( size_t i = 0; i < rows; i++ )
+				sum += hammingDistanceScalar( q, db + i * words, words );
+			s_sink = sumScalar = sum;
+		} );
+		const double usPair = bestTime( hammingRepeats, [ & ]
+		{
+			uint64_t sum = 0;
+			for( size_t i = 0; i < rows; i++ )
+				sum += hammingDistance( q, db + i * words, words );
+			s_sink = sumAvx = sum;
+		} );
+
+		std::vector<uint32_t> distancesScalar( rows ), distances( rows );
+		const double usManyScalar = bestTime( hammingRepeats, [ & ] { hammingDistancesScalar( q, db, rows, words, distancesScalar.data() ); } );
+		const double usMany = bestTime( hammingRepeats, [ & ] { hammingDistances( q, db, rows, words, distances.data() ); } );
+
+		std::vector<sSearchResult> topk;
+		const double usTopK = bestTime( hammingRepeats, [ & ] { topk = hammingTopK( q, db, rows, words, hammingK ); } );
+
+		// The top-k distances must be equal to the smallest ones of the scalar version; the indices may differ when there're ties
+		std::vector<uint32_t> smallest = distancesScalar;
+		const size_t k = std::min( hammingK, rows );
+		std::partial_sort( smallest.begin(), smallest.begin() + k, smallest.end() );
+		bool topkCorrect = topk.size() == k;
+		for( size_t i = 0; topkCorrect && i < k; i++ )
+			topkCorrect = (uint32_t)topk[ i ].score == smallest[ i ] && distancesScalar[ topk[ i ].index ] == smallest[ i ];
+
+		const double bytes = (double)( rows * words * 8 );
+		printf( "%i bits, %i vectors, %.1f MB\n", (int)bits, (int)rows, bytes / ( 1 << 20 ) );
+		auto print = [ & ]( const char* name, double us, double usBaseline )
+		{
+			printf( "  %s: %g us, %.2f ns/vector, %.1f GB/s, %.2fx faster\n", name, us, us * 1E3 / (double)rows, bytes / us * 1E-3, usBaseline / us );
+		};
+		print( "single pair, scalar POPCNT", usPairScalar, usPairScalar );
+		print( "single pair, AVX2", usPair, usPairScalar );
+		print( "one to many, scalar POPCNT", usManyScalar, usManyScalar );
+		print( "one to many, AVX2", usMany, usManyScalar );
+		print( "top 10, AVX2", usTopK, usManyScalar );
+
+		if( sumScalar != sumAvx || distancesScalar != distances || !topkCorrect )
+		{
+			printf( "  Error: the AVX2 results are different from scalar\n" );
+			exitCode = 1;
+		}
+		else
+			printf( "  Verified: AVX2 distances are equal to scalar, the closest one is %i bits away\n", (int)smallest[ 0 ] );
+	}
+	return exitCode;
+}
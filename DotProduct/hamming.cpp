@@ -0,0 +1,115 @@
+#include "stdafx.h"
+#include "hamming.h"
+// Hamming distances, this source file is compiled for AVX2 + POPCNT.
+
+uint32_t hammingDistanceScalar( const uint64_t* a, const uint64_t* b, size_t words )
+{
+	uint64_t result = 0;
+	for( size_t i = 0; i < words; i++ )
+		result += (uint64_t)_mm_popcnt_u64( a[ i ] ^ b[ i ] );
+	return (uint32_t)result;
+}
+
+// Count bits in every byte: look up both 4-bit halves in a 16-entry table
+__forceinline __m256i popcountBytes( __m256i v )
+{
+	const __m256i lut = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+	const __m256i lowNibble = _mm256_set1_epi8( 0x0F );
+	const __m256i low = _mm256_and_si256( v, lowNibble );
+	const __m256i high = _mm256_and_si256( _mm256_srli_epi16( v, 4 ), lowNibble );
+	return _mm256_add_epi8( _mm256_shuffle_epi8( lut, low ), _mm256_shuffle_epi8( lut, high ) );
+}
+
+__forceinline __m256i xorVectors( const uint64_t* a, const uint64_t* b )
+{
+	return _mm256_xor_si256( _mm256_loadu_si256( ( const __m256i* )a ), _mm256_loadu_si256( ( const __m256i* )b ) );
+}
+
+__forceinline uint32_t avx_hamming( const uint64_t* a, const uint64_t* b, size_t words )
+{
+	// A byte counts at most 8 bits per vector, so the byte counters can take 31 vectors without overflow.
+	// Accumulate up to 16 vectors in bytes, then vpsadbw sums groups of 8 bytes into 64-bit lanes.
+	constexpr size_t wordsPerVector = 4;
+	constexpr size_t vectorsPerBatch = 16;
+	const size_t vectors = words / wordsPerVector;
+
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	while( i < vectors )
+	{
+		const size_t batchEnd = std::min( i + vectorsPerBatch, vectors );
+		__m256i bytes = _mm256_setzero_si256();
+		for( ; i < batchEnd; i++ )
+			bytes = _mm256_add_epi8( bytes, popcountBytes( xorVectors( a + i * wordsPerVector, b + i * wordsPerVector ) ) );
+		acc = _mm256_add_epi64( acc, _mm256_sad_epu8( bytes, _mm256_setzero_si256() ) );
+	}
+
+	const __m128i r2 = _mm_add_epi64( _mm256_castsi256_si128( acc ), _mm256_extracti128_si256( acc, 1 ) );
+	uint64_t result = (uint64_t)_mm_cvtsi128_si64( r2 ) + (uint64_t)_mm_extract_epi64( r2, 1 );
+	// The remaining 0-3 words
+	for( size_t w = vectors * wordsPerVector; w < words; w++ )
+		result += (uint64_t)_mm_popcnt_u64( a[ w ] ^ b[ w ] );
+	return (uint32_t)result;
+}
+
+uint32_t hammingDistance( const uint64_t* a, const uint64_t* b, size_t words )
+{
+	return avx_hamming( a, b, words );
+}
+
+void hammingDistancesScalar( const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* result )
+{
+	for( size_t i = 0; i < count; i++, rows += words )
+		result[ i ] = hammingDistanceScalar( query, rows, words );
+}
+
+// With the length known at compile time the loops are unrolled, and the query stays in registers
+template<size_t words>
+static void avx_hamming_fixed( const uint64_t* query, const uint64_t* rows, size_t count, uint32_t* result )
+{
+	for( size_t i = 0; i < count; i++, rows += words )
+		result[ i ] = avx_hamming( query, rows, words );
+}
+
+void hammingDistances( const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* result )
+{
+	switch( words )
+	{
+	case 4:
+		avx_hamming_fixed<4>( query, rows, count, result );
+		return;
+	case 8:
+		avx_hamming_fixed<8>( query, rows, count, result );
+		return;
+	case 16:
+		avx_hamming_fixed<16>( query, rows, count, result );
+		return;
+	}
+	for( size_t i = 0; i < count; i++, rows += words )
+		result[ i ] = avx_hamming( query, rows, words );
+}
+
+std::vector<sSearchResult> hammingTopK( const uint64_t* query, const uint64_t* rows, size_t count, size_t words, size_t k )
+{
+	// TopK keeps the largest scores, the distances are negated. Both are exact in floats, the distances are way less than 2^24.
+	constexpr size_t blockRows = 256;
+	alignas( 32 ) std::array<uint32_t, blockRows> distances;
+	alignas( 32 ) std::array<float, blockRows> scores;
+	TopK topk{ k };
+	for( size_t row = 0; row < count; row += blockRows )
+	{
+		const size_t n = std::min( blockRows, count - row );
+		hammingDistances( query, rows + row * words, n, words, distances.data() );
+		for( size_t i = 0; i < n; i += 8 )
+		{
+			const __m256i d = _mm256_load_si256( ( const __m256i* )( distances.data() + i ) );
+			_mm256_store_ps( scores.data() + i, _mm256_cvtepi32_ps( _mm256_sub_epi32( _mm256_setzero_si256(), d ) ) );
+		}
+		topk.pushBlock( scores.data(), n, (uint32_t)row );
+	}
+
+	std::vector<sSearchResult> result = topk.sorted();
+	for( sSearchResult& r : result )
+		r.score = -r.score;
+	return result;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "search.h"
+
+// Hamming distances between binary vectors, XOR + population count. The vectors are arrays of `words` 64-bit words, e.g. 4 words for 256 bits.
+// The scalar versions use POPCNT instruction, the other ones count bits with AVX2 vpshufb nibble lookup and vpsadbw. All of them require AVX2, and POPCNT which comes with it.
+
+uint32_t hammingDistanceScalar( const uint64_t* a, const uint64_t* b, size_t words );
+uint32_t hammingDistance( const uint64_t* a, const uint64_t* b, size_t words );
+
+// Distances from the query to `count` rows stored sequentially
+void hammingDistancesScalar( const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* result );
+void hammingDistances( const uint64_t* query, const uint64_t* rows, size_t count, size_t words, uint32_t* result );
+
+// k rows closest to the query, sorted by ascending distance. The scores of the results are the distances.
+std::vector<sSearchResult> hammingTopK( const uint64_t* query, const uint64_t* rows, size_t count, size_t words, size_t k );
@@ -0,0 +1,52 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// 8M floats = 32MB per vector, quantized copies are 8MB each
+constexpr size_t int8DefaultLength = 8 * 1024 * 1024;
+constexpr int int8Repeats = 10;
+
+// The optional argument is length of the vectors
+int benchmarkInt8( int argc, const char* argv[] )
+{
+	size_t count = int8DefaultLength;
+	if( !parseLength( argc, argv, count ) )
+		return 2;
+
+	auto v1 = alignedArray<float>( count );
+	auto v2 = alignedArray<float>( count );
+	fillRandomVector( true, v1.get(), count, 11 );
+	fillRandomVector( true, v2.get(), count, 12 );
+	// The first vector is non-negative for the uint8 version. Make the second one signed, [ -1 .. +1 ]
+	for( size_t i = 0; i < count; i++ )
+		v2[ i ] = v2[ i ] * 2 - 1;
+	const long double reference = referenceDotProduct( v1.get(), v2.get(), count );
+
+	float result = 0;
+	const double usFloat = bestTime( int8Repeats, [ & ]()
+	{
+		result = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( v1.get(), v2.get(), count );
+	} );
+	printf( "%i values\n", (int)count );
+	printResult( "fp32 AvxVerticalFma4", usFloat, (double)( count * 8 ), result, reference, usFloat );
+
+	// The relative errors are dominated by the quantization of the inputs
+	auto signed1 = alignedArray<int8_t>( count );
+	auto unsigned1 = alignedArray<uint8_t>( count );
+	auto signed2 = alignedArray<int8_t>( count );
+	const float scaleSigned1 = quantizeInt8( v1.get(), signed1.get(), count );
+	const float scaleUnsigned1 = quantizeUint8( v1.get(), unsigned1.get(), count );
+	const float scale2 = quantizeInt8( v2.get(), signed2.get(), count );
+
+	double us = bestTime( int8Repeats, [ & ]()
+	{
+		result = dotProductInt8( signed1.get(), scaleSigned1, signed2.get(), scale2, count );
+	} );
+	printResult( "int8 * int8", us, (double)( count * 2 ), result, reference, usFloat );
+
+	us = bestTime( int8Repeats, [ & ]()
+	{
+		result = dotProductUint8( unsigned1.get(), scaleUnsigned1, signed2.get(), scale2, count );
+	} );
+	printResult( "uint8 * int8", us, (double)( count * 2 ), result, reference, usFloat );
+	return 0;
+}
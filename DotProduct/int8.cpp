@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+// Quantized 8-bit vectors. This source file is compiled for AVX2 + FMA3.
+// vpmaddubsw multiplies unsigned bytes by signed bytes and adds adjacent pairs into int16 lanes with saturation, vpmaddwd adds adjacent int16 pairs into int32.
+
+// Products of 32 pairs of bytes, summed into 8 int32 lanes.
+// For int8 * int8, both vectors must be in [ -127, 127 ] range: then |a| * sign( b, a ) is at most 127 * 127, a pair of them doesn't saturate int16.
+// For uint8 * int8, the full range is supported, see below.
+template<bool unsignedFirst>
+__forceinline __m256i products( __m256i a, __m256i b )
+{
+	const __m256i ones = _mm256_set1_epi16( 1 );
+	if constexpr( unsignedFirst )
+	{
+		// 255 * -128 * 2 doesn't fit in int16. Split the unsigned bytes into lower 7 bits and the highest one, a = low + 128 * high.
+		// Then low * b pairs are at most 127 * 128 * 2, high * b pairs at most 256, neither one saturates.
+		const __m256i low = _mm256_and_si256( a, _mm256_set1_epi8( 0x7F ) );
+		const __m256i high = _mm256_and_si256( _mm256_srli_epi16( a, 7 ), _mm256_set1_epi8( 1 ) );
+		const __m256i productsLow = _mm256_madd_epi16( _mm256_maddubs_epi16( low, b ), ones );
+		const __m256i productsHigh = _mm256_madd_epi16( _mm256_maddubs_epi16( high, b ), _mm256_set1_epi16( 128 ) );
+		return _mm256_add_epi32( productsLow, productsHigh );
+	}
+	else
+	{
+		// The first operand of vpmaddubsw is unsigned, move the sign of a into b
+		const __m256i absA = _mm256_abs_epi8( a );
+		const __m256i signedB = _mm256_sign_epi8( b, a );
+		return _mm256_madd_epi16( _mm256_maddubs_epi16( absA, signedB ), ones );
+	}
+}
+
+__forceinline __m256i load( const void* p )
+{
+	return _mm256_loadu_si256( ( const __m256i* )p );
+}
+
+// Add int32 lanes to int64 lanes
+__forceinline __m256i widenAdd( __m256i acc, __m256i v )
+{
+	acc = _mm256_add_epi64( acc, _mm256_cvtepi32_epi64( _mm256_castsi256_si128( v ) ) );
+	return _mm256_add_epi64( acc, _mm256_cvtepi32_epi64( _mm256_extracti128_si256( v, 1 ) ) );
+}
+
+template<class T1>
+__forceinline int64_t avx_int8_multi( const T1* p1, const int8_t* p2, size_t count )
+{
+	constexpr bool unsignedFirst = std::is_same_v<T1, uint8_t>;
+	constexpr size_t valuesPerLoop = 32 * 4;
+	// Every iteration adds at most 2 * 2 * 255 * 128 to each int32 lane. Sum in blocks of 8192 iterations so they don't overflow, then add to int64 lanes.
+	constexpr size_t valuesPerBlock = valuesPerLoop * 8192;
+	const size_t remainder = count % valuesPerLoop;
+	const T1* const p1End = p1 + ( count - remainder );
+
+	__m256i result = _mm256_setzero_si256();
+	while( p1 < p1End )
+	{
+		const T1* const blockEnd = p1 + std::min( (size_t)( p1End - p1 ), valuesPerBlock );
+		__m256i dot0 = _mm256_setzero_si256();
+		__m256i dot1 = _mm256_setzero_si256();
+		__m256i dot2 = _mm256_setzero_si256();
+		__m256i dot3 = _mm256_setzero_si256();
+		for( ; p1 < blockEnd; p1 += valuesPerLoop, p2 += valuesPerLoop )
+		{
+			dot0 = _mm256_add_epi32( dot0, products<unsignedFirst>( load( p1 ), load( p2 ) ) );
+			dot1 = _mm256_add_epi32( dot1, products<unsignedFirst>( load( p1 + 32 ), load( p2 + 32 ) ) );
+			dot2 = _mm256_add_epi32( dot2, products<unsignedFirst>( load( p1 + 64 ), load( p2 + 64 ) ) );
+			dot3 = _mm256_add_epi32( dot3, products<unsignedFirst>( load( p1 + 96 ), load( p2 + 96 ) ) );
+		}
+		result = widenAdd( result, dot0 );
+		result = widenAdd( result, dot1 );
+		result = widenAdd( result, dot2 );
+		result = widenAdd( result, dot3 );
+	}
+
+	// Up to 3 remaining complete vectors, then 1-31 remaining values copied into a buffer padded with zeros
+	__m256i dot = _mm256_setzero_si256();
+	const T1* const p1EndVectors = p1 + ( remainder - remainder % 32 );
+	for( ; p1 < p1EndVectors; p1 += 32, p2 += 32 )
+		dot = _mm256_add_epi32( dot, products<unsignedFirst>( load( p1 ), load( p2 ) ) );
+	if( 0 != remainder % 32 )
+	{
+		alignas( 32 ) int8_t buffer1[ 32 ] = {}, buffer2[ 32 ] = {};
+		memcpy( buffer1, p1, remainder % 32 );
+		memcpy( buffer2, p2, remainder % 32 );
+		dot = _mm256_add_epi32( dot, products<unsignedFirst>( load( buffer1 ), load( buffer2 ) ) );
+	}
+	result = widenAdd( result, dot );
+
+	const __m128i r2 = _mm_add_epi64( _mm256_castsi256_si128( result ), _mm256_extracti128_si256( result, 1 ) );
+	return _mm_cvtsi128_si64( r2 ) + _mm_extract_epi64( r2, 1 );
+}
+
+float dotProductInt8( const int8_t* p1, float scale1, const int8_t* p2, float scale2, size_t count )
+{
+	return (float)( (double)avx_int8_multi( p1, p2, count ) * scale1 * scale2 );
+}
+
+float dotProductUint8( const uint8_t* p1, float scale1, const int8_t* p2, float scale2, size_t count )
+{
+	return (float)( (double)avx_int8_multi( p1, p2, count ) * scale1 * scale2 );
+}
+
+// The quantization is not performance critical, scalar code is good enough
+
+float quantizeInt8( const float* src, int8_t* dst, size_t count )
+{
+	float maxAbs = 0;
+	for( size_t i = 0; i < count; i++ )
+		maxAbs = std::max( maxAbs, std::abs( src[ i ] ) );
+	if( 0 == maxAbs )
+	{
+		memset( dst, 0, count );
+		return 1;
+	}
+	const float scale = maxAbs / 127;
+	const float mul = 127 / maxAbs;
+	for( size_t i = 0; i < count; i++ )
+		dst[ i ] = (int8_t)std::clamp( std::lround( src[ i ] * mul ), -127l, 127l );
+	return scale;
+}
+
+float quantizeUint8( const float* src, uint8_t* dst, size_t count )
+{
+	float maxValue = 0;
+	for( size_t i = 0; i < count; i++ )
+		maxValue = std::max( maxValue, src[ i ] );
+	if( 0 == maxValue )
+	{
+		memset( dst, 0, count );
+		return 1;
+	}
+	const float scale = maxValue / 255;
+	const float mul = 255 / maxValue;
+	for( size_t i = 0; i < count; i++ )
+		dst[ i ] = (uint8_t)std::clamp( std::lround( src[ i ] * mul ), 0l, 255l );
+	return scale;
+}
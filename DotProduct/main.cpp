@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "benchmarks.h"
 
 // constexpr size_t vectorLength = 64 * 1024 * 1024;
 constexpr size_t vectorLength = 256 * 1024;	// 256k floats = 1MB of data.
@@ -6,33 +7,117 @@ constexpr size_t vectorLength = 256 * 1024;	// 256k floats = 1MB of data.
 // Just for lulz, you can replace this with false, and the source data will be produced in a way so it's not on the cache when calling the dotProduct function, and see what happens.
 constexpr bool cacheInputData = true;
 
+struct sBenchmark
+{
+	const char* name;
+	int( *pfn )( int argc, const char* argv[] );
+	eInstructionSet requiredInstructionSet;
+	const char* description;
+};
+
+static const sBenchmark s_benchmarks[] =
+{
+	{ "check", &checkLengths, eInstructionSet::Sse2, "verify all supported algorithms for all lengths up to 257" },
+	{ "cosine", &benchmarkCosine, eInstructionSet::Avx2, "cosine similarity in a single pass, versus 3 dot products; optional argument is the length" },
+	{ "file", &benchmarkFile, eInstructionSet::Sse2, "dot products of vectors in a memory-mapped raw float32 file; run without arguments for the usage" },
+	{ "fixed", &benchmarkFixed, eInstructionSet::Avx2, "tiny dot products of 16-64 floats unrolled at compile time, versus the runtime length; optional argument is count of calls" },
+	{ "gemm", &benchmarkGemm, eInstructionSet::Avx2, "multiply square matrices, versus a naive triple loop; optional argument is the size" },
+	{ "gemv", &benchmarkGemv, eInstructionSet::Avx2, "dot products of a vector with every row of a matrix, versus a loop; optional arguments are count of rows and their length" },
+	{ "half", &benchmarkHalf, eInstructionSet::Avx2, "fp16 and bf16 versions of the vectors, versus fp32; optional argument is the length" },
+	{ "hamming", &benchmarkHamming, eInstructionSet::Avx2, "Hamming distances of 256-1024 bit vectors, scalar POPCNT versus AVX2; optional argument is count of vectors" },
+	{ "int8", &benchmarkInt8, eInstructionSet::Avx2, "int8 and uint8 quantized versions of the vectors, versus fp32; optional argument is the length" },
+	{ "pq", &benchmarkPq, eInstructionSet::Avx2, "4-bit product quantization scan, versus exhaustive dot products; optional argument is count of vectors" },
+	{ "prefetch", &benchmarkPrefetch, eInstructionSet::Avx2, "sweep prefetch distances with the data not in cache; optional argument is the length" },
+	{ "random", &benchmarkRandom, eInstructionSet::Sse2, "generate random vectors with SIMD on all threads, versus the serial generator; optional argument is the length" },
+	{ "reduce", &benchmarkReduce, eInstructionSet::Avx2, "distances, sum, min, max and argmax with 1-4 accumulators; optional argument is the length" },
+	{ "repro", &benchmarkReproducible, eInstructionSet::Sse2, "reproducible dot product, verify identical results and measure the cost; optional argument is the length" },
+	{ "search", &benchmarkSearch, eInstructionSet::Avx2, "brute-force top 10 search, queries per second; optional argument is count of rows" },
+	{ "soa", &benchmarkSoa, eInstructionSet::Avx2, "batches of short dot products in structure-of-arrays layout, versus a loop; optional argument is count of pairs" },
+	{ "sparse", &benchmarkSparse, eInstructionSet::Avx2, "sparse * dense vectors for different densities; optional argument is length of the dense vector" },
+	{ "sparse2", &benchmarkSparseSparse, eInstructionSet::Avx2, "sparse * sparse vectors for different overlap ratios; optional argument is count of non-zero elements" },
+	{ "stream", &benchmarkStreaming, eInstructionSet::Sse2, "out-of-core dot product of a raw float32 file, double-buffered reads overlapped with compute; run without arguments for the usage" },
+	{ "sweep", &benchmarkSweep, eInstructionSet::Sse2, "all algorithms for lengths from 1k to 16M, prints statistics; optional arguments are csv or json, and repetitions count" },
+};
+
 static void printHelp()
 {
-	printf( "Valid arguments:\n" );
+	printf( "Valid arguments, the algorithm can be followed by prefetch distance in bytes:\n" );
 	for( uint8_t i = 0; i < (uint8_t)eDotProductAlgorithm::valuesCount; i++ )
-		printf( "%i: %s\n", (int)i, algorithmName( (eDotProductAlgorithm)i ) );
+	{
+		const eDotProductAlgorithm algo = (eDotProductAlgorithm)i;
+		if( isSupported( requiredInstructionSet( algo ) ) )
+			printf( "%i: %s\n", (int)i, algorithmName( algo ) );
+		else
+			printf( "%i: %s, requires %s\n", (int)i, algorithmName( algo ), instructionSetName( requiredInstructionSet( algo ) ) );
+	}
+	printf( "auto: the fastest one supported by this CPU, %s\n", algorithmName( fastestAlgorithm() ) );
+	for( const sBenchmark& b : s_benchmarks )
+		printf( "%s: %s\n", b.name, b.description );
+	printf( "Append hugepages to any of these to allocate arrays of 2MB or more in transparent huge pages\n" );
+}
+
+// If the first argument is the name of a benchmark, run it and return true.
+static bool runBenchmark( int argc, const char* argv[], int& exitCode )
+{
+	for( const sBenchmark& b : s_benchmarks )
+	{
+		if( 0 != strcmp( argv[ 1 ], b.name ) )
+			continue;
+		if( !isSupported( b.requiredInstructionSet ) )
+		{
+			printf( "%s benchmark requires %s, this CPU only supports %s\n", b.name,
+				instructionSetName( b.requiredInstructionSet ), instructionSetName( supportedInstructionSet() ) );
+			exitCode = 3;
+			return true;
+		}
+		exitCode = b.pfn( argc - 2, argv + 2 );
+		return true;
+	}
+	return false;
 }
 
 int main( int argc, const char* argv[] )
 {
-	if( argc != 2 )
+	parseHugePagesArgument( argc, argv );
+	int exitCode;
+	if( argc >= 2 && runBenchmark( argc, argv, exitCode ) )
+		return exitCode;
+
+	if( argc != 2 && argc != 3 )
 	{
 		printHelp();
 		return 1;
 	}
 	int algoInt;
-	if( !nonstd::atoi( argv[ 1 ], algoInt ) || algoInt < 0 || algoInt >= (int)eDotProductAlgorithm::valuesCount )
+	if( 0 == strcmp( argv[ 1 ], "auto" ) )
+		algoInt = (int)fastestAlgorithm();
+	else if( !nonstd::atoi( argv[ 1 ], algoInt ) || algoInt < 0 || algoInt >= (int)eDotProductAlgorithm::valuesCount )
 	{
 		printf( "Please provide a single integer argument, within [ 0 .. %i ] interval\n", (int)eDotProductAlgorithm::valuesCount - 1 );
 		printHelp();
 		return 2;
 	}
 
+	// The optional second argument is the prefetch distance in bytes, for the versions which prefetch
+	if( argc == 3 )
+	{
+		int distance;
+		if( !nonstd::atoi( argv[ 2 ], distance ) || distance < 0 )
+		{
+			printf( "Invalid prefetch distance \"%s\"\n", argv[ 2 ] );
+			return 2;
+		}
+		setPrefetchDistance( (size_t)distance );
+	}
+
 	const eDotProductAlgorithm algo = (eDotProductAlgorithm)algoInt;
-	auto v1 = alignedArray<float>( vectorLength );
-	auto v2 = alignedArray<float>( vectorLength );
+	// Blocks smaller than 2MB stay in 4kb pages. With hugepages argument, the vectors are padded to 2MB so they qualify.
+	const size_t allocLength = ( eAllocationPolicy::HugePages == allocationPolicy() ) ? std::max( vectorLength, details::hugePageSize / sizeof( float ) ) : vectorLength;
+	auto v1 = alignedArray<float>( allocLength );
+	auto v2 = alignedArray<float>( allocLength );
 	fillRandomVector( cacheInputData, v1.get(), vectorLength, 11 );
 	fillRandomVector( cacheInputData, v2.get(), vectorLength, 12 );
+	printAllocationPolicy();
 	dispatchAndMeasure( algo, v1.get(), v2.get(), vectorLength );
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "mappedFile.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+
+MappedFile::MappedFile( const char* path, const sOptions& options )
+{
+#ifdef __linux__
+	const int fd = open( path, O_RDONLY );
+	if( fd < 0 )
+	{
+		error = errno;
+		return;
+	}
+
+	struct stat st;
+	if( 0 != fstat( fd, &st ) )
+	{
+		error = errno;
+		close( fd );
+		return;
+	}
+	if( st.st_size <= 0 )
+	{
+		// mmap doesn't support empty mappings
+		error = EINVAL;
+		close( fd );
+		return;
+	}
+	length = (size_t)st.st_size;
+
+	if( options.dropCache )
+	{
+		// The advice is not binding, ignoring the error
+		posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+	}
+
+	const int flags = MAP_PRIVATE | ( options.populate ? MAP_POPULATE : 0 );
+	void* const p = mmap( nullptr, length, PROT_READ, flags, fd, 0 );
+	// The mapping keeps the file referenced, the descriptor is no longer needed
+	if( MAP_FAILED == p )
+		error = errno;
+	close( fd );
+	if( MAP_FAILED == p )
+	{
+		length = 0;
+		return;
+	}
+	pointer = p;
+
+	if( options.sequential )
+		madvise( p, length, MADV_SEQUENTIAL );
+	if( options.willNeed )
+		madvise( p, length, MADV_WILLNEED );
+#else
+	error = ENOSYS;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef __linux__
+	if( nullptr != pointer )
+		munmap( const_cast<void*>( pointer ), length );
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "../common.h"
+
+// Read-only memory mapping of a complete file, the vectors are used directly from the page cache without copying.
+// Implemented with mmap on Linux. On other OSes the mapping fails with ENOSYS error code.
+class MappedFile
+{
+	const void* pointer = nullptr;
+	size_t length = 0;
+	int error = 0;
+
+public:
+	struct sOptions
+	{
+		// MAP_POPULATE: read the file and map all pages before the constructor returns, the computations then run without page faults
+		bool populate = false;
+		// madvise( MADV_SEQUENTIAL ): aggressive read-ahead, the pages behind can be reclaimed early
+		bool sequential = false;
+		// madvise( MADV_WILLNEED ): start reading the file into the page cache asynchronously
+		bool willNeed = false;
+		// posix_fadvise( POSIX_FADV_DONTNEED ) before mapping: evict the file from the page cache, to measure reading it from the disk.
+		// The kernel only drops clean pages which aren't mapped by other processes.
+		bool dropCache = false;
+	};
+
+	MappedFile( const char* path, const sOptions& options );
+	~MappedFile();
+
+	MappedFile( const MappedFile& ) = delete;
+	void operator=( const MappedFile& ) = delete;
+
+	bool valid() const
+	{
+		return nullptr != pointer;
+	}
+
+	// errno of the failed system call, or 0 if the file was mapped
+	int errorCode() const
+	{
+		return error;
+	}
+
+	const float* floats() const
+	{
+		return (const float*)pointer;
+	}
+
+	size_t bytes() const
+	{
+		return length;
+	}
+};
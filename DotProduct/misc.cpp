@@ -1,4 +1,6 @@
 #include "stdafx.h"
+#include "threadPool.h"
+#include "random.hpp"
 
 const char* algorithmName( eDotProductAlgorithm algo )
 {
@@ -20,25 +22,176 @@ const char* algorithmName( eDotProductAlgorithm algo )
 		AN( SseVerticalFma4 );
 		AN( AvxVerticalFma4 );
 		AN( SseVertical4 );
+		AN( AvxVertical4 );
+		AN( ParallelAvxFma4 );
+		AN( AvxKahanFma2 );
+		AN( AvxKahanFma4 );
+		AN( AvxDot2Fma2 );
+		AN( AvxDot2Fma4 );
+		AN( AvxVerticalFma4PrefetchT0 );
+		AN( AvxVerticalFma4PrefetchNta );
+		AN( SseReproducible );
+		AN( AvxReproducible );
+		AN( ParallelReproducible );
 #undef AN
 	}
 	return nullptr;
 }
 
+eInstructionSet requiredInstructionSet( eDotProductAlgorithm algo )
+{
+	switch( algo )
+	{
+	case eDotProductAlgorithm::Scalar:
+	case eDotProductAlgorithm::ScalarDouble:
+	case eDotProductAlgorithm::SseReproducible:
+	case eDotProductAlgorithm::ParallelReproducible:
+		return eInstructionSet::Sse2;
+	case eDotProductAlgorithm::SseDpPs:
+	case eDotProductAlgorithm::SseVertical:
+	case eDotProductAlgorithm::SseVertical4:
+		return eInstructionSet::Sse41;
+	case eDotProductAlgorithm::AvxDpPs:
+	case eDotProductAlgorithm::AvxVertical:
+	case eDotProductAlgorithm::AvxVertical4:
+	case eDotProductAlgorithm::AvxReproducible:
+		return eInstructionSet::Avx;
+	default:
+		// Everything else uses FMA
+		return eInstructionSet::Avx2;
+	}
+}
+
+eDotProductAlgorithm fastestAlgorithm()
+{
+	static const eDotProductAlgorithm fastest = []()
+	{
+		switch( supportedInstructionSet() )
+		{
+		case eInstructionSet::Avx2:
+			return eDotProductAlgorithm::AvxVerticalFma4;
+		case eInstructionSet::Avx:
+			return eDotProductAlgorithm::AvxVertical4;
+		case eInstructionSet::Sse41:
+			return eDotProductAlgorithm::SseVertical4;
+		default:
+			return eDotProductAlgorithm::Scalar;
+		}
+	}();
+	return fastest;
+}
+
+pfnDotProduct dotProductFunc( eDotProductAlgorithm algo )
+{
+	switch( algo )
+	{
+#define AN( T ) case eDotProductAlgorithm::T: return &dotProduct<eDotProductAlgorithm::T>;
+		AN( Scalar );
+		AN( ScalarDouble );
+		AN( SseDpPs );
+		AN( AvxDpPs );
+		AN( SseVertical );
+		AN( AvxVertical );
+		AN( SseVerticalFma );
+		AN( AvxVerticalFma );
+		AN( SseVerticalFma2 );
+		AN( AvxVerticalFma2 );
+		AN( SseVerticalFma3 );
+		AN( AvxVerticalFma3 );
+		AN( SseVerticalFma4 );
+		AN( AvxVerticalFma4 );
+		AN( SseVertical4 );
+		AN( AvxVertical4 );
+		AN( ParallelAvxFma4 );
+		AN( AvxKahanFma2 );
+		AN( AvxKahanFma4 );
+		AN( AvxDot2Fma2 );
+		AN( AvxDot2Fma4 );
+		AN( AvxVerticalFma4PrefetchT0 );
+		AN( AvxVerticalFma4PrefetchNta );
+		AN( SseReproducible );
+		AN( AvxReproducible );
+		AN( ParallelReproducible );
+#undef AN
+	}
+	return nullptr;
+}
+
+long double referenceDotProduct( const float* p1, const float* p2, size_t count )
+{
+	long double result = 0;
+	for( size_t i = 0; i < count; i++ )
+		result += (long double)p1[ i ] * (long double)p2[ i ];
+	return result;
+}
+
+// Print the result, along with the relative error. The reference is computed after the measurement, it would otherwise load the data in cache.
+static void printResult( eDotProductAlgorithm algo, double us, float result, const float* p1, const float* p2, size_t count )
+{
+	const long double reference = referenceDotProduct( p1, p2, count );
+	const double error = (double)( std::abs( (long double)result - reference ) / std::abs( reference ) );
+	printf( "%s: %g us, result %g, relative error %g\n", algorithmName( algo ), us, (double)result, error );
+}
+
 template<eDotProductAlgorithm algo>
 static void measure( const float* p1, const float* p2, size_t count )
 {
+	PerfCounters counters;
+	counters.start();
 	const Stopwatch stopwatch;
 	const float res = dotProduct<algo>( p1, p2, count );
 	const double us = stopwatch.elapsedMicroseconds();
-	printf( "%s: %g us, result %g\n", algorithmName( algo ), us, (double)res );
+	counters.stop();
+	printResult( algo, us, res, p1, p2, count );
+	counters.print( count );
+}
+
+// The multi-threaded version also measures the single-threaded kernel it's built from, to report the scaling efficiency.
+template<>
+void measure<eDotProductAlgorithm::ParallelAvxFma4>( const float* p1, const float* p2, size_t count )
+{
+	// Launch and wake up the worker threads, we don't want to measure that.
+	ThreadPool& pool = ThreadPool::shared();
+	pool.parallelFor( pool.threadsCount(), []( size_t ) {} );
+	const size_t threads = pool.threadsCount();
+	// Warm up caches and TLB, so both measurements below start in the same state.
+	// The results go to a volatile variable, otherwise the compiler drops these calls because the results are unused.
+	volatile float sink = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( p1, p2, count );
+
+	double usSingle;
+	{
+		const Stopwatch stopwatch;
+		sink = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( p1, p2, count );
+		usSingle = stopwatch.elapsedMicroseconds();
+	}
+	(void)sink;
+
+	// The counters only count events of the calling thread, one piece of the work
+	PerfCounters counters;
+	counters.start();
+	const Stopwatch stopwatch;
+	const float res = dotProduct<eDotProductAlgorithm::ParallelAvxFma4>( p1, p2, count );
+	const double us = stopwatch.elapsedMicroseconds();
+	counters.stop();
+
+	// Efficiency is the speedup divided by threads count, 100% means perfect scaling
+	const double speedup = usSingle / us;
+	printResult( eDotProductAlgorithm::ParallelAvxFma4, us, res, p1, p2, count );
+	printf( "%i threads, single-threaded %g us, speedup %.2fx, scaling efficiency %.0f%%\n", (int)threads, usSingle, speedup, 100.0 * speedup / (double)threads );
+	counters.print( count );
 }
 
 // Run the specified algorithm, print time in milliseconds, and the result.
 void dispatchAndMeasure( eDotProductAlgorithm algo, const float* p1, const float* p2, size_t count )
 {
-	// Some of the tests don't use upper 128 bits of YMM registers. fillRandomVector did, and we don't want any false data dependencies across registers.
-	_mm256_zeroupper();
+	if( !isSupported( requiredInstructionSet( algo ) ) )
+	{
+		printf( "%s requires %s, this CPU only supports %s\n", algorithmName( algo ),
+			instructionSetName( requiredInstructionSet( algo ) ), instructionSetName( supportedInstructionSet() ) );
+		return;
+	}
+
+	// Compilers emit vzeroupper instruction at the end of every function which uses AVX, we don't need to do that manually.
 	switch( algo )
 	{
 #define AN( T ) case eDotProductAlgorithm::T: measure<eDotProductAlgorithm::T>( p1, p2, count ); return
@@ -57,68 +210,123 @@ void dispatchAndMeasure( eDotProductAlgorithm algo, const float* p1, const float
 		AN( SseVerticalFma4 );
 		AN( AvxVerticalFma4 );
 		AN( SseVertical4 );
+		AN( AvxVertical4 );
+		AN( ParallelAvxFma4 );
+		AN( AvxKahanFma2 );
+		AN( AvxKahanFma4 );
+		AN( AvxDot2Fma2 );
+		AN( AvxDot2Fma4 );
+		AN( AvxVerticalFma4PrefetchT0 );
+		AN( AvxVerticalFma4PrefetchNta );
+		AN( SseReproducible );
+		AN( AvxReproducible );
+		AN( ParallelReproducible );
 #undef AN
 	}
 }
 
-// Convert 256 random bits into 16 uniformly-distributed random floats, in range [0..1)
-inline __m256 randomFloats( __m256i randomBits )
+// Low 32 bits of the products of 4 lanes by the constant. SSE2 doesn't have pmulld, it only multiplies even lanes into 64-bit products.
+__forceinline __m128i mullo_epi32( __m128i a, uint32_t b )
 {
-	// Cast to random float bits. This doesn't change any bits, that intrinsic compiles into no instructions and does an equivalent of reinterpret_cast
-	__m256 result = _mm256_castsi256_ps( randomBits );
+	const __m128i bb = _mm_set1_epi32( (int)b );
+	const __m128i even = _mm_mul_epu32( a, bb );
+	const __m128i odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), bb );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
 
-	// Zero out sign + exponent bits, leave random bits in mantissa.
-	const __m256 mantissaMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x007FFFFF ) );
-	result = _mm256_and_ps( result, mantissaMask );
+__forceinline __m128i lowbias32( __m128i x )
+{
+	x = _mm_xor_si128( x, _mm_srli_epi32( x, 16 ) );
+	x = mullo_epi32( x, 0x7feb352du );
+	x = _mm_xor_si128( x, _mm_srli_epi32( x, 15 ) );
+	x = mullo_epi32( x, 0x846ca68bu );
+	x = _mm_xor_si128( x, _mm_srli_epi32( x, 16 ) );
+	return x;
+}
 
-	// Set sign + exponent bits to that of 1.0, which is sign=0, exponent=2^0.
-	const __m256 one = _mm256_set1_ps( 1.0f );
-	result = _mm256_or_ps( result, one );
+// Convert 128 random bits into 4 uniformly-distributed random floats, in range [0..1), same as randomFloat function
+inline __m128 randomFloats( __m128i randomBits )
+{
+	// Keep 23 random bits in mantissa, set sign + exponent bits to that of 1.0, which is sign=0, exponent=2^0.
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 result = _mm_or_ps( _mm_castsi128_ps( _mm_srli_epi32( randomBits, 9 ) ), one );
 
 	// Subtract 1.0. The above algorithm generates floats in range [1..2)
 	// Can't use bit tricks to generate floats in [0..1) because it would cause them to be distributed very unevenly.
-	return _mm256_sub_ps( result, one );
+	return _mm_sub_ps( result, one );
 }
 
+// SSE2 version of fillRandomAvx2, 4 lanes. This code runs on any AMD64 processor.
 template<bool cache>
-static void fillRandomVector( float* ptr, size_t count, uint32_t randomSeed )
+static void fillRandomSse2( float* ptr, size_t begin, size_t end, RandomKey key )
 {
-	assert( 0 == count % 8 );
-	assert( 0 == (size_t)( ptr ) % 32 );
-
-	// Generate random integers
-	std::independent_bits_engine<std::default_random_engine, 32, uint32_t> re{ randomSeed };
-	auto randomBits = alignedArray<uint32_t>( count );
-	std::generate( randomBits.get(), randomBits.get() + count, std::ref( re ) );
-
-	// Convert integer bits into uniformly distributed floats: https://stackoverflow.com/a/54873925/126995
-	const __m256i* src = ( const __m256i* )randomBits.get();
-	const __m256i* const srcEnd = src + count / 8;
-	__m256* dest = ( __m256* )ptr;
-	for( ; src < srcEnd; src++, dest++ )
+	const __m128i lanes = _mm_setr_epi32( 0, 1, 2, 3 );
+	const __m128i four = _mm_set1_epi32( 4 );
+	size_t i = begin;
+	while( i < end )
 	{
-		// Load values bypassing cache
-		const __m256i bits = _mm256_stream_load_si256( src );
-		// Generate the floats
-		const __m256 floats = randomFloats( bits );
+		// The keys only change every 2^32 elements
+		const RandomKey k = randomKeyForIndex( key, i );
+		const size_t blockEnd = std::min( end, (size_t)( ( (uint64_t)i | 0xFFFFFFFFull ) + 1 ) );
+
+		for( ; i < blockEnd && 0 != ( (size_t)( ptr + i ) % 16 ); i++ )
+			ptr[ i ] = randomFloat( randomBits( k, (uint32_t)i ) );
 
-		if constexpr( cache )
+		const __m128i k1 = _mm_set1_epi32( (int)k.k1 );
+		const __m128i k2 = _mm_set1_epi32( (int)k.k2 );
+		__m128i index = _mm_add_epi32( _mm_set1_epi32( (int)(uint32_t)i ), lanes );
+		for( ; i + 4 <= blockEnd; i += 4 )
 		{
-			// Store the value in memory, also cache
-			_mm256_store_ps( (float*)dest, floats );
+			const __m128 floats = randomFloats( lowbias32( _mm_xor_si128( lowbias32( _mm_xor_si128( index, k1 ) ), k2 ) ) );
+			index = _mm_add_epi32( index, four );
+			if constexpr( cache )
+			{
+				// Store the value in memory, also cache
+				_mm_store_ps( ptr + i, floats );
+			}
+			else
+			{
+				// Store the value in memory, bypassing caches
+				_mm_stream_ps( ptr + i, floats );
+			}
 		}
+
+		for( ; i < blockEnd; i++ )
+			ptr[ i ] = randomFloat( randomBits( k, (uint32_t)i ) );
+	}
+
+	if constexpr( !cache )
+		_mm_sfence();
+}
+
+void fillRandomFloats( eInstructionSet isa, bool cacheData, float* ptr, size_t count, uint32_t seed, bool multithreaded )
+{
+	const RandomKey key = randomKey( seed );
+	// Pieces of 1M floats, 4MB each. The numbers only depend on the indices, the split doesn't affect them.
+	constexpr size_t piece = 1 << 20;
+	const size_t pieces = ( count + piece - 1 ) / piece;
+	auto fill = [ = ]( size_t i )
+	{
+		const size_t begin = i * piece;
+		const size_t end = std::min( count, begin + piece );
+		if( isa >= eInstructionSet::Avx2 )
+			fillRandomAvx2( cacheData, ptr, begin, end, key );
+		else if( cacheData )
+			fillRandomSse2<true>( ptr, begin, end, key );
 		else
-		{
-			// Store the value in memory, bypassing caches
-			_mm256_stream_ps( (float*)dest, floats );
-		}
+			fillRandomSse2<false>( ptr, begin, end, key );
+	};
+
+	if( multithreaded )
+		ThreadPool::shared().parallelFor( pieces, fill );
+	else
+	{
+		for( size_t i = 0; i < pieces; i++ )
+			fill( i );
 	}
 }
 
 void fillRandomVector( bool cacheData, float* ptr, size_t count, uint32_t randomSeed )
 {
-	if( cacheData )
-		fillRandomVector<true>( ptr, count, randomSeed );
-	else
-		fillRandomVector<false>( ptr, count, randomSeed );
+	fillRandomFloats( supportedInstructionSet(), cacheData, ptr, count, randomSeed, true );
 }
\ No newline at end of file
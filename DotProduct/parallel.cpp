@@ -0,0 +1,33 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "threadPool.h"
+
+// ==== Multi-threaded version, splits the vectors into equal pieces, one per thread ====
+
+template<>
+float dotProduct<eDotProductAlgorithm::ParallelAvxFma4>( const float* p1, const float* p2, size_t count )
+{
+	// avx_vertical_multi<4> consumes 32 floats per iteration. Pieces are multiples of that, only the last one has a remainder.
+	constexpr size_t valuesPerLoop = 32;
+
+	ThreadPool& pool = ThreadPool::shared();
+	const size_t threads = pool.threadsCount();
+	size_t piece = ( count + threads - 1 ) / threads;
+	piece = std::max( ( piece + valuesPerLoop - 1 ) / valuesPerLoop * valuesPerLoop, valuesPerLoop );
+	const size_t pieces = ( count + piece - 1 ) / piece;
+
+	// The partial sums are written once per thread, no need to pad them against false sharing
+	std::vector<float> partialSums( pieces );
+	pool.parallelFor( pieces, [ =, &partialSums ]( size_t i )
+	{
+		const size_t offset = i * piece;
+		const size_t length = std::min( piece, count - offset );
+		partialSums[ i ] = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( p1 + offset, p2 + offset, length );
+	} );
+
+	// Combine the partial sums in the same order regardless on which threads computed them, the result only depends on the threads count.
+	double result = 0;
+	for( float f : partialSums )
+		result += f;
+	return (float)result;
+}
@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "pq.h"
+#include "search.h"
+
+// 1M vectors * 64 floats = 256MB. With 16 subspaces the codes take 8 bytes / vector, 8MB total.
+constexpr size_t pqDefaultRows = 1024 * 1024;
+constexpr size_t pqDims = 64;
+constexpr size_t pqSubspaces = 16;
+constexpr size_t pqK = 10;
+// The approximate top-R candidates are checked for the exact top-k, for the recall k@R
+constexpr size_t pqCandidates = 100;
+constexpr int pqQueries = 10;
+
+// Top-k of the scores of all rows
+static std::vector<sSearchResult> topScores( const std::vector<float>& scores, size_t k )
+{
+	TopK topk{ k };
+	topk.pushBlock( scores.data(), scores.size(), 0 );
+	return topk.sorted();
+}
+
+// Count of the reference results found in the first `count` approximate ones
+static size_t countFound( const std::vector<sSearchResult>& reference, const std::vector<sSearchResult>& approx, size_t count )
+{
+	count = std::min( count, approx.size() );
+	size_t found = 0;
+	for( const sSearchResult& r : reference )
+		found += std::any_of( approx.begin(), approx.begin() + count, [ & ]( const sSearchResult& a ) { return a.index == r.index; } ) ? 1 : 0;
+	return found;
+}
+
+// The optional argument is count of vectors
+int benchmarkPq( int argc, const char* argv[] )
+{
+	size_t rows = pqDefaultRows;
+	if( !parseLength( argc, argv, rows ) )
+		return 2;
+
+	auto vectors = alignedArray<float>( rows * pqDims );
+	auto queries = alignedArray<float>( pqQueries * pqDims );
+	fillRandomVector( true, vectors.get(), rows * pqDims, 11 );
+	fillRandomVector( true, queries.get(), pqQueries * pqDims, 12 );
+	const ProductQuantizer pq{ pqDims, pqSubspaces, 13 };
+	const std::vector<uint8_t> codes = pq.encode( vectors.get(), rows );
+
+	std::vector<float> exactScores( rows ), approxScores( rows );
+	double usExact = 0, usLut = 0, usScan = 0;
+	size_t foundK = 0, foundR = 0;
+	for( int q = 0; q < pqQueries; q++ )
+	{
+		const float* const query = queries.get() + q * pqDims;
+		{
+			const Stopwatch stopwatch;
+			for( size_t i = 0; i < rows; i++ )
+				exactScores[ i ] = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( vectors.get() + i * pqDims, query, pqDims );
+			usExact += stopwatch.elapsedMicroseconds();
+		}
+		ProductQuantizer::Lut lut;
+		{
+			const Stopwatch stopwatch;
+			lut = pq.buildLut( query );
+			usLut += stopwatch.elapsedMicroseconds();
+		}
+		{
+			const Stopwatch stopwatch;
+			pq.scan( lut, codes.data(), rows, approxScores.data() );
+			usScan += stopwatch.elapsedMicroseconds();
+		}
+
+		const std::vector<sSearchResult> reference = topScores( exactScores, pqK );
+		const std::vector<sSearchResult> approx = topScores( approxScores, pqCandidates );
+		foundK += countFound( reference, approx, pqK );
+		foundR += countFound( reference, approx, pqCandidates );
+	}
+
+	const double mul = 1.0 / pqQueries;
+	const double total = (double)( pqK * pqQueries );
+	printf( "%i vectors * %i floats, %i subspaces * 16 centroids, %i queries\n", (int)rows, (int)pqDims, (int)pqSubspaces, pqQueries );
+	printf( "Exhaustive AvxVerticalFma4: %g us / query, %.1f M vectors / second, %.1f GB/s\n",
+		usExact * mul, (double)rows * pqQueries / usExact, (double)( rows * pqDims * 4 ) * pqQueries / usExact * 1E-3 );
+	printf( "PQ scan: %g us / query, %.1f M vectors / second, %.1f GB/s, %.1fx faster; building the tables %g us / query\n",
+		usScan * mul, (double)rows * pqQueries / usScan, (double)codes.size() * pqQueries / usScan * 1E-3, usExact / usScan, usLut * mul );
+	printf( "Recall %i@%i: %.1f%%, %i@%i: %.1f%%\n", (int)pqK, (int)pqK, 100.0 * (double)foundK / total, (int)pqK, (int)pqCandidates, 100.0 * (double)foundR / total );
+	return 0;
+}
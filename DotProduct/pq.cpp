@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#include "pq.h"
+// Product quantization, this source file is compiled for AVX2 + FMA3.
+
+ProductQuantizer::ProductQuantizer( size_t dims, size_t subspaces, uint32_t seed ) :
+	dims( dims ), subspaces( subspaces ), subspaceDims( dims / subspaces )
+{
+	if( 0 == subspaces || 0 != subspaces % 2 || 0 != dims % subspaces )
+		throw std::invalid_argument( "ProductQuantizer: subspaces count must be even, and dims must be a multiple of it" );
+	centroids.resize( subspaces * centroidsCount * subspaceDims );
+	fillRandomVector( true, centroids.data(), centroids.size(), seed );
+}
+
+// Encoding is not performance critical, scalar code is good enough
+std::vector<uint8_t> ProductQuantizer::encode( const float* vectors, size_t count ) const
+{
+	const size_t blocks = ( count + blockVectors - 1 ) / blockVectors;
+	std::vector<uint8_t> codes( blocks * blockBytes(), 0 );
+	for( size_t v = 0; v < count; v++ )
+	{
+		const float* const vec = vectors + v * dims;
+		uint8_t* const block = codes.data() + ( v / blockVectors ) * blockBytes();
+		for( size_t s = 0; s < subspaces; s++ )
+		{
+			// The closest centroid by L2 distance
+			const float* const sub = vec + s * subspaceDims;
+			const float* c = centroids.data() + s * centroidsCount * subspaceDims;
+			uint8_t best = 0;
+			float bestDistance = std::numeric_limits<float>::max();
+			for( size_t i = 0; i < centroidsCount; i++, c += subspaceDims )
+			{
+				float dist = 0;
+				for( size_t j = 0; j < subspaceDims; j++ )
+					dist += ( sub[ j ] - c[ j ] ) * ( sub[ j ] - c[ j ] );
+				if( dist < bestDistance )
+				{
+					bestDistance = dist;
+					best = (uint8_t)i;
+				}
+			}
+			uint8_t& b = block[ ( s / 2 ) * blockVectors + v % blockVectors ];
+			b |= ( s % 2 ) ? (uint8_t)( best << 4 ) : best;
+		}
+	}
+	return codes;
+}
+
+ProductQuantizer::Lut ProductQuantizer::buildLut( const float* query ) const
+{
+	// Dot products with all centroids
+	std::vector<float> dots( subspaces * centroidsCount );
+	const float* c = centroids.data();
+	for( size_t s = 0; s < subspaces; s++ )
+	{
+		for( size_t i = 0; i < centroidsCount; i++, c += subspaceDims )
+			dots[ s * centroidsCount + i ] = dotProduct<eDotProductAlgorithm::AvxVerticalFma>( query + s * subspaceDims, c, subspaceDims );
+	}
+
+	// Subtract minimum of each subspace, and scale all of them by the same factor so the largest range maps to [ 0 .. 255 ]
+	std::vector<float> minimums( subspaces );
+	float maxRange = 0;
+	Lut lut;
+	lut.bias = 0;
+	for( size_t s = 0; s < subspaces; s++ )
+	{
+		const float* const d = dots.data() + s * centroidsCount;
+		const auto mm = std::minmax_element( d, d + centroidsCount );
+		minimums[ s ] = *mm.first;
+		lut.bias += *mm.first;
+		maxRange = std::max( maxRange, *mm.second - *mm.first );
+	}
+	const float mul = ( maxRange > 0 ) ? 255.0f / maxRange : 0.0f;
+	lut.scale = ( maxRange > 0 ) ? maxRange / 255.0f : 0.0f;
+
+	lut.tables.resize( dots.size() );
+	for( size_t i = 0; i < dots.size(); i++ )
+		lut.tables[ i ] = (uint8_t)std::lround( ( dots[ i ] - minimums[ i / centroidsCount ] ) * mul );
+	return lut;
+}
+
+// Accumulate 32 bytes into 16-bit sums of the even and odd bytes, with unsigned saturation.
+// Saturation doesn't happen with less than 257 subspaces, it's only there for safety.
+__forceinline void accumulateBytes( __m256i bytes, __m256i& even, __m256i& odd )
+{
+	even = _mm256_adds_epu16( even, _mm256_and_si256( bytes, _mm256_set1_epi16( 0xFF ) ) );
+	odd = _mm256_adds_epu16( odd, _mm256_srli_epi16( bytes, 8 ) );
+}
+
+void ProductQuantizer::scan( const Lut& lut, const uint8_t* codes, size_t count, float* scores ) const
+{
+	const size_t pairs = subspaces / 2;
+	const uint8_t* const tables = lut.tables.data();
+	const __m256i lowNibble = _mm256_set1_epi8( 0x0F );
+	const __m256 scale = _mm256_set1_ps( lut.scale );
+	const __m256 bias = _mm256_set1_ps( lut.bias );
+
+	for( size_t v = 0; v < count; v += blockVectors, codes += blockBytes() )
+	{
+		__m256i even = _mm256_setzero_si256();
+		__m256i odd = _mm256_setzero_si256();
+		for( size_t p = 0; p < pairs; p++ )
+		{
+			const __m256i c = _mm256_loadu_si256( ( const __m256i* )( codes + p * blockVectors ) );
+			const __m256i codesLow = _mm256_and_si256( c, lowNibble );
+			const __m256i codesHigh = _mm256_and_si256( _mm256_srli_epi16( c, 4 ), lowNibble );
+			// pshufb looks up within 16-byte lanes, both halves of the register need the same table
+			const __m256i tableLow = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )( tables + p * 32 ) ) );
+			const __m256i tableHigh = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )( tables + p * 32 + 16 ) ) );
+			accumulateBytes( _mm256_shuffle_epi8( tableLow, codesLow ), even, odd );
+			accumulateBytes( _mm256_shuffle_epi8( tableHigh, codesHigh ), even, odd );
+		}
+
+		// 16-bit lane i of `even` has vector 2i, of `odd` has vector 2i + 1. Interleave them back into the order of the vectors.
+		const __m256i lo = _mm256_unpacklo_epi16( even, odd );	// vectors 0-7, 16-23
+		const __m256i hi = _mm256_unpackhi_epi16( even, odd );	// vectors 8-15, 24-31
+		const __m256i sums[ 4 ] =
+		{
+			_mm256_cvtepu16_epi32( _mm256_castsi256_si128( lo ) ),
+			_mm256_cvtepu16_epi32( _mm256_castsi256_si128( hi ) ),
+			_mm256_cvtepu16_epi32( _mm256_extracti128_si256( lo, 1 ) ),
+			_mm256_cvtepu16_epi32( _mm256_extracti128_si256( hi, 1 ) ),
+		};
+		const size_t remaining = std::min( count - v, blockVectors );
+		if( remaining == blockVectors )
+		{
+			for( int i = 0; i < 4; i++ )
+				_mm256_storeu_ps( scores + v + i * 8, _mm256_fmadd_ps( _mm256_cvtepi32_ps( sums[ i ] ), scale, bias ) );
+		}
+		else
+		{
+			// The last incomplete block
+			alignas( 32 ) float buffer[ blockVectors ];
+			for( int i = 0; i < 4; i++ )
+				_mm256_store_ps( buffer + i * 8, _mm256_fmadd_ps( _mm256_cvtepi32_ps( sums[ i ] ), scale, bias ) );
+			std::copy_n( buffer, remaining, scores + v );
+		}
+	}
+}
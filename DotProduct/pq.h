@@ -0,0 +1,39 @@
+#pragma once
+#include "../common.h"
+
+// Product quantizer with 4-bit codes: the vectors are split into subspaces, each subspace is encoded as the index of the closest of 16 centroids.
+// The codes are stored in blocks of 32 vectors. A block has subspaces / 2 rows of 32 bytes; byte j of row i has the code of vector j for subspace 2i in the lower 4 bits, and for subspace 2i+1 in the higher 4 bits.
+// The layout is for asymmetric distance computation with pshufb: one instruction looks up a 16-entry table for 32 vectors.
+class ProductQuantizer
+{
+	size_t dims, subspaces, subspaceDims;
+	// [ subspace ][ centroid ][ subspaceDims ]
+	std::vector<float> centroids;
+
+public:
+	static constexpr size_t centroidsCount = 16;
+	static constexpr size_t blockVectors = 32;
+
+	// Create with random codebooks from fillRandomVector. The subspaces count must be even, and dims must be a multiple of it.
+	ProductQuantizer( size_t dims, size_t subspaces, uint32_t seed );
+
+	size_t blockBytes() const
+	{
+		return subspaces / 2 * blockVectors;
+	}
+
+	// Encode the vectors into blocks, the last block is padded with zero codes
+	std::vector<uint8_t> encode( const float* vectors, size_t count ) const;
+
+	// Lookup tables for a query: the dot products of the query with all centroids, quantized to bytes.
+	// The approximate dot product is bias + scale * ( sum of the table entries for the codes ).
+	struct Lut
+	{
+		std::vector<uint8_t> tables;
+		float scale, bias;
+	};
+	Lut buildLut( const float* query ) const;
+
+	// Compute approximate dot products of the query with the encoded vectors. Requires AVX2.
+	void scan( const Lut& lut, const uint8_t* codes, size_t count, float* scores ) const;
+};
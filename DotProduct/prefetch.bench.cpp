@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// 8M floats = 32MB per vector. The vectors are evicted from caches before every measurement anyway.
+constexpr size_t prefetchDefaultLength = 8 * 1024 * 1024;
+constexpr int prefetchRepeats = 5;
+
+// Evict the vector from all levels of the cache hierarchy
+static void flushCache( const float* p, size_t count )
+{
+	const char* ptr = (const char*)p;
+	const char* const end = (const char*)( p + count );
+	for( ; ptr < end; ptr += 64 )
+		_mm_clflush( ptr );
+	_mm_mfence();
+}
+
+// Fastest time of several runs, each one with the data in DRAM
+static double measureUncached( eDotProductAlgorithm algo, const float* p1, const float* p2, size_t count )
+{
+	const pfnDotProduct pfn = dotProductFunc( algo );
+	double result = std::numeric_limits<double>::max();
+	for( int i = 0; i < prefetchRepeats; i++ )
+	{
+		flushCache( p1, count );
+		flushCache( p2, count );
+		const Stopwatch stopwatch;
+		// Volatile store, otherwise the compiler drops the call because the result is unused
+		volatile float dot = pfn( p1, p2, count );
+		(void)dot;
+		result = std::min( result, stopwatch.elapsedMicroseconds() );
+	}
+	return result;
+}
+
+// The optional argument is length of the vectors
+int benchmarkPrefetch( int argc, const char* argv[] )
+{
+	size_t count = prefetchDefaultLength;
+	if( !parseLength( argc, argv, count ) )
+		return 2;
+
+	auto v1 = alignedArray<float>( count );
+	auto v2 = alignedArray<float>( count );
+	fillRandomVector( true, v1.get(), count, 11 );
+	fillRandomVector( true, v2.get(), count, 12 );
+	const double bytes = (double)( count * 8 );
+
+	const double usBaseline = measureUncached( eDotProductAlgorithm::AvxVerticalFma4, v1.get(), v2.get(), count );
+	printf( "%i values, not in cache\n", (int)count );
+	printf( "AvxVerticalFma4 without prefetch: %g us, %.1f GB/s\n", usBaseline, bytes / usBaseline * 1E-3 );
+
+	const size_t savedDistance = getPrefetchDistance();
+	printf( "Distance, bytes\tT0, GB/s\tNTA, GB/s\n" );
+	for( size_t distance = 64; distance <= 16 * 1024; distance *= 2 )
+	{
+		setPrefetchDistance( distance );
+		const double usT0 = measureUncached( eDotProductAlgorithm::AvxVerticalFma4PrefetchT0, v1.get(), v2.get(), count );
+		const double usNta = measureUncached( eDotProductAlgorithm::AvxVerticalFma4PrefetchNta, v1.get(), v2.get(), count );
+		printf( "%i\t%.1f\t%.1f\n", (int)distance, bytes / usT0 * 1E-3, bytes / usNta * 1E-3 );
+	}
+	setPrefetchDistance( savedDistance );
+	return 0;
+}
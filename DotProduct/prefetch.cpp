@@ -0,0 +1,65 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// AvxVerticalFma4 with software prefetch, this source file is compiled for AVX2 + FMA3.
+// Hardware prefetchers don't cross 4kb pages, and need a few misses to detect the stream. Explicit prefetch hides more of the DRAM latency when the distance matches the memory of the computer.
+
+static size_t s_prefetchDistance = 1024;
+
+void setPrefetchDistance( size_t bytes )
+{
+	s_prefetchDistance = bytes;
+}
+
+size_t getPrefetchDistance()
+{
+	return s_prefetchDistance;
+}
+
+// The main loop consumes 32 floats = 2 cache lines of each vector per iteration, it prefetches 2 lines of both vectors that far ahead.
+// Prefetch instructions don't fault, it's OK when the address is past the end of the vectors.
+// The hint is a template argument because the instruction encodes it. It is an enum in GCC and an int in VC++, hence auto.
+template<auto hint>
+__forceinline float avx_vertical_prefetch( const float* p1, const float* p2, size_t count )
+{
+	constexpr int valuesPerLoop = 32;
+	const size_t distance = s_prefetchDistance / 4;
+	const size_t remainder = count % valuesPerLoop;
+	const float* const p1End = p1 + ( count - remainder );
+
+	__m256 dot0 = _mm256_setzero_ps();
+	__m256 dot1 = _mm256_setzero_ps();
+	__m256 dot2 = _mm256_setzero_ps();
+	__m256 dot3 = _mm256_setzero_ps();
+	for( ; p1 < p1End; p1 += valuesPerLoop, p2 += valuesPerLoop )
+	{
+		_mm_prefetch( (const char*)( p1 + distance ), hint );
+		_mm_prefetch( (const char*)( p1 + distance + 16 ), hint );
+		_mm_prefetch( (const char*)( p2 + distance ), hint );
+		_mm_prefetch( (const char*)( p2 + distance + 16 ), hint );
+
+		dot0 = _mm256_fmadd_ps( _mm256_loadu_ps( p1 ), _mm256_loadu_ps( p2 ), dot0 );
+		dot1 = _mm256_fmadd_ps( _mm256_loadu_ps( p1 + 8 ), _mm256_loadu_ps( p2 + 8 ), dot1 );
+		dot2 = _mm256_fmadd_ps( _mm256_loadu_ps( p1 + 16 ), _mm256_loadu_ps( p2 + 16 ), dot2 );
+		dot3 = _mm256_fmadd_ps( _mm256_loadu_ps( p1 + 24 ), _mm256_loadu_ps( p2 + 24 ), dot3 );
+	}
+
+	const __m256 dot01 = _mm256_add_ps( dot0, dot1 );
+	const __m256 dot23 = _mm256_add_ps( dot2, dot3 );
+	float result = hadd_ps( _mm256_add_ps( dot01, dot23 ) );
+	// The remaining 0-31 floats, without prefetch
+	if( 0 != remainder )
+		result += avx_vertical_multi<4>( p1, p2, remainder );
+	return result;
+}
+
+template<>
+float dotProduct<eDotProductAlgorithm::AvxVerticalFma4PrefetchT0>( const float* p1, const float* p2, size_t count )
+{
+	return avx_vertical_prefetch<_MM_HINT_T0>( p1, p2, count );
+}
+template<>
+float dotProduct<eDotProductAlgorithm::AvxVerticalFma4PrefetchNta>( const float* p1, const float* p2, size_t count )
+{
+	return avx_vertical_prefetch<_MM_HINT_NTA>( p1, p2, count );
+}
@@ -0,0 +1,62 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "random.hpp"
+#include "threadPool.h"
+
+// 64M floats, 256MB
+constexpr size_t randomDefaultLength = 64 * 1024 * 1024;
+constexpr int randomRepeats = 3;
+
+// The generator fillRandomVector used before: std::independent_bits_engine into a temporary array, then conversion to floats
+static void fillRandomSerial( float* ptr, size_t count, uint32_t seed )
+{
+	std::independent_bits_engine<std::default_random_engine, 32, uint32_t> re{ seed };
+	auto randomBits = alignedArray<uint32_t>( count );
+	std::generate( randomBits.get(), randomBits.get() + count, std::ref( re ) );
+	for( size_t i = 0; i < count; i++ )
+		ptr[ i ] = randomFloat( randomBits[ i ] );
+}
+
+// The optional argument is the length
+int benchmarkRandom( int argc, const char* argv[] )
+{
+	size_t length = randomDefaultLength;
+	if( !parseLength( argc, argv, length ) )
+		return 2;
+
+	auto reference = alignedArray<float>( length );
+	auto buffer = alignedArray<float>( length );
+	const double bytes = (double)length * 4;
+	const double usSerial = bestTime( randomRepeats, [ & ]() { fillRandomSerial( buffer.get(), length, 11 ); } );
+	printf( "%i floats\nSerial std::independent_bits_engine: %g us, %.2f GB/s\n", (int)length, usSerial, bytes / usSerial * 1E-3 );
+
+	// Every combination of the instruction set and threads must produce the same numbers, with both normal and non-temporal stores
+	fillRandomFloats( eInstructionSet::Sse2, true, reference.get(), length, 11, false );
+	std::vector<eInstructionSet> isas{ eInstructionSet::Sse2 };
+	if( isSupported( eInstructionSet::Avx2 ) )
+		isas.push_back( eInstructionSet::Avx2 );
+	int exitCode = 0;
+	for( eInstructionSet isa : isas )
+		for( bool multithreaded : { false, true } )
+			for( bool cacheData : { true, false } )
+			{
+				const double us = bestTime( randomRepeats, [ & ]() { fillRandomFloats( isa, cacheData, buffer.get(), length, 11, multithreaded ); } );
+				const bool same = 0 == memcmp( buffer.get(), reference.get(), length * 4 );
+				printf( "%s, %s, %s stores: %g us, %.2f GB/s, %.1fx faster%s\n", instructionSetName( isa ),
+					multithreaded ? "all threads" : "1 thread", cacheData ? "normal" : "non-temporal",
+					us, bytes / us * 1E-3, usSerial / us, same ? "" : "; ERROR: different numbers" );
+				if( !same )
+					exitCode = 1;
+			}
+
+	// Moments of the uniform distribution in [ 0 .. 1 ): mean 1/2, variance 1/12
+	double sum = 0, sumSquares = 0;
+	for( size_t i = 0; i < length; i++ )
+	{
+		sum += reference[ i ];
+		sumSquares += (double)reference[ i ] * reference[ i ];
+	}
+	const double mean = sum / (double)length;
+	printf( "Mean %.6f, expected 0.5; variance %.6f, expected %.6f; %i threads\n", mean, sumSquares / (double)length - mean * mean, 1.0 / 12, (int)ThreadPool::shared().threadsCount() );
+	return exitCode;
+}
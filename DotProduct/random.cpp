@@ -0,0 +1,67 @@
+#include "stdafx.h"
+#include "random.hpp"
+// Random numbers, AVX2 version. This source file is compiled for AVX2 + FMA3.
+
+__forceinline __m256i lowbias32( __m256i x )
+{
+	x = _mm256_xor_si256( x, _mm256_srli_epi32( x, 16 ) );
+	x = _mm256_mullo_epi32( x, _mm256_set1_epi32( 0x7feb352d ) );
+	x = _mm256_xor_si256( x, _mm256_srli_epi32( x, 15 ) );
+	x = _mm256_mullo_epi32( x, _mm256_set1_epi32( (int)0x846ca68bu ) );
+	x = _mm256_xor_si256( x, _mm256_srli_epi32( x, 16 ) );
+	return x;
+}
+
+// 8 random floats for the 8 sequential indices in the vector
+__forceinline __m256 randomFloats( __m256i index, __m256i k1, __m256i k2 )
+{
+	const __m256i bits = lowbias32( _mm256_xor_si256( lowbias32( _mm256_xor_si256( index, k1 ) ), k2 ) );
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	const __m256 f = _mm256_or_ps( _mm256_castsi256_ps( _mm256_srli_epi32( bits, 9 ) ), one );
+	return _mm256_sub_ps( f, one );
+}
+
+template<bool cache>
+static void fillRandom( float* ptr, size_t begin, size_t end, RandomKey key )
+{
+	const __m256i lanes = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	const __m256i eight = _mm256_set1_epi32( 8 );
+	size_t i = begin;
+	while( i < end )
+	{
+		// The keys only change every 2^32 elements
+		const RandomKey k = randomKeyForIndex( key, i );
+		const size_t blockEnd = std::min( end, (size_t)( ( (uint64_t)i | 0xFFFFFFFFull ) + 1 ) );
+
+		// The scalar code handles the elements until the first 32-byte aligned one, and the remainder
+		for( ; i < blockEnd && 0 != ( (size_t)( ptr + i ) % 32 ); i++ )
+			ptr[ i ] = randomFloat( randomBits( k, (uint32_t)i ) );
+
+		const __m256i k1 = _mm256_set1_epi32( (int)k.k1 );
+		const __m256i k2 = _mm256_set1_epi32( (int)k.k2 );
+		__m256i index = _mm256_add_epi32( _mm256_set1_epi32( (int)(uint32_t)i ), lanes );
+		for( ; i + 8 <= blockEnd; i += 8 )
+		{
+			const __m256 floats = randomFloats( index, k1, k2 );
+			index = _mm256_add_epi32( index, eight );
+			if constexpr( cache )
+				_mm256_store_ps( ptr + i, floats );
+			else
+				_mm256_stream_ps( ptr + i, floats );
+		}
+
+		for( ; i < blockEnd; i++ )
+			ptr[ i ] = randomFloat( randomBits( k, (uint32_t)i ) );
+	}
+
+	if constexpr( !cache )
+		_mm_sfence();
+}
+
+void fillRandomAvx2( bool cacheData, float* ptr, size_t begin, size_t end, RandomKey key )
+{
+	if( cacheData )
+		fillRandom<true>( ptr, begin, end, key );
+	else
+		fillRandom<false>( ptr, begin, end, key );
+}
@@ -0,0 +1,57 @@
+#pragma once
+// Counter-based random numbers: the 32 random bits for the element i are a hash of i and the seed.
+// Unlike sequential generators, any element can be computed independently, the vectors are generated with SIMD in all lanes and on all threads at once,
+// and the result doesn't depend on the instruction set or the count of threads.
+// The hash is 2 rounds of lowbias32 by Chris Wellons, with the key mixed in before each round. That's not a cryptographic quality, but it's plenty for the benchmarks.
+
+// The keys derived from the seed
+struct RandomKey
+{
+	uint32_t k1, k2;
+};
+
+__forceinline uint32_t lowbias32( uint32_t x )
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+inline RandomKey randomKey( uint32_t seed )
+{
+	const uint32_t k1 = lowbias32( seed ^ 0x9E3779B9u );
+	const uint32_t k2 = lowbias32( k1 + 0x6A09E667u );
+	return RandomKey{ k1, k2 };
+}
+
+// The high half of the 64-bit index is folded into the second key, the vectors longer than 2^32 don't repeat
+__forceinline RandomKey randomKeyForIndex( RandomKey key, uint64_t index )
+{
+	return RandomKey{ key.k1, key.k2 + (uint32_t)( index >> 32 ) * 0xBB67AE85u };
+}
+
+// The random bits of the element, the key must come from randomKeyForIndex
+__forceinline uint32_t randomBits( RandomKey key, uint32_t index )
+{
+	return lowbias32( lowbias32( index ^ key.k1 ) ^ key.k2 );
+}
+
+// Convert random bits into uniformly-distributed float in [ 0 .. 1 ): set the exponent of 1.0 and 23 random bits of mantissa, then subtract 1.0
+// https://stackoverflow.com/a/54873925/126995
+__forceinline float randomFloat( uint32_t bits )
+{
+	const uint32_t u = ( bits >> 9 ) | 0x3F800000u;
+	float f;
+	memcpy( &f, &u, 4 );
+	return f - 1.0f;
+}
+
+// Fill elements [ begin .. end ) of the array, with AVX2. With cacheData = false it uses non-temporal stores.
+void fillRandomAvx2( bool cacheData, float* ptr, size_t begin, size_t end, RandomKey key );
+
+// Fill the buffer with random floats with the specified instruction set, SSE2 or AVX2, optionally on all threads of the shared pool.
+// All combinations produce the same numbers for the same seed.
+void fillRandomFloats( eInstructionSet isa, bool cacheData, float* ptr, size_t count, uint32_t seed, bool multithreaded );
@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// 256k floats = 1MB per vector, same as the main benchmark
+constexpr size_t reduceDefaultLength = 256 * 1024;
+constexpr int reduceRepeats = 20;
+
+// Measure the reduction with 1-4 accumulators, print time and bandwidth for each, and verify against the reference
+template<class TFunc>
+static bool measureReduction( const char* name, size_t bytes, double reference, bool exact, TFunc func )
+{
+	printf( "%s", name );
+	bool ok = true;
+	auto run = [ & ]( auto accumulators )
+	{
+		double result = 0;
+		const double us = bestTime( reduceRepeats, [ & ]() { result = func( accumulators ); } );
+		printf( "\t%g us, %.1f GB/s", us, (double)bytes / us * 1E-3 );
+		const double error = std::abs( result - reference ) / std::max( std::abs( reference ), 1E-30 );
+		if( exact ? ( result != reference ) : ( error > 1E-4 ) )
+		{
+			printf( " FAILED: %g, expected %g", result, reference );
+			ok = false;
+		}
+	};
+	run( std::integral_constant<int, 1>{} );
+	run( std::integral_constant<int, 2>{} );
+	run( std::integral_constant<int, 3>{} );
+	run( std::integral_constant<int, 4>{} );
+	printf( "\n" );
+	return ok;
+}
+
+// The existing dot product kernels with 1-4 accumulators
+static constexpr eDotProductAlgorithm reduceDotAlgorithm( int accumulators )
+{
+	switch( accumulators )
+	{
+	case 1:
+		return eDotProductAlgorithm::AvxVerticalFma;
+	case 2:
+		return eDotProductAlgorithm::AvxVerticalFma2;
+	case 3:
+		return eDotProductAlgorithm::AvxVerticalFma3;
+	default:
+		return eDotProductAlgorithm::AvxVerticalFma4;
+	}
+}
+
+// The optional argument is length of the vectors
+int benchmarkReduce( int argc, const char* argv[] )
+{
+	size_t count = reduceDefaultLength;
+	if( !parseLength( argc, argv, count ) )
+		return 2;
+	auto v1 = alignedArray<float>( count );
+	auto v2 = alignedArray<float>( count );
+	fillRandomVector( true, v1.get(), count, 11 );
+	fillRandomVector( true, v2.get(), count, 12 );
+	const float* const p1 = v1.get();
+	const float* const p2 = v2.get();
+
+	// Scalar references, the sums in double precision
+	double dot = 0, l2 = 0, l1 = 0, sum = 0;
+	float min = std::numeric_limits<float>::infinity(), max = -min;
+	size_t maxIndex = 0;
+	for( size_t i = 0; i < count; i++ )
+	{
+		const double a = p1[ i ], b = p2[ i ];
+		dot += a * b;
+		l2 += ( a - b ) * ( a - b );
+		l1 += std::abs( a - b );
+		sum += a;
+		min = std::min( min, p1[ i ] );
+		if( p1[ i ] > max )
+		{
+			max = p1[ i ];
+			maxIndex = i;
+		}
+	}
+
+	const size_t bytes1 = count * 4, bytes2 = count * 8;
+	printf( "%i floats, 1-4 accumulators; dot is AvxVerticalFma with 1-4 accumulators\n", (int)count );
+	bool ok = true;
+	ok &= measureReduction( "dot", bytes2, dot, false, [ & ]( auto acc ) { return dotProduct<reduceDotAlgorithm( acc )>( p1, p2, count ); } );
+	ok &= measureReduction( "L2^2", bytes2, l2, false, [ & ]( auto acc ) { return squaredL2Distance<acc>( p1, p2, count ); } );
+	ok &= measureReduction( "L1", bytes2, l1, false, [ & ]( auto acc ) { return l1Distance<acc>( p1, p2, count ); } );
+	ok &= measureReduction( "sum", bytes1, sum, false, [ & ]( auto acc ) { return sumFloats<acc>( p1, count ); } );
+	ok &= measureReduction( "min", bytes1, min, true, [ & ]( auto acc ) { return minimum<acc>( p1, count ); } );
+	ok &= measureReduction( "max", bytes1, max, true, [ & ]( auto acc ) { return maximum<acc>( p1, count ); } );
+	ok &= measureReduction( "argmax", bytes1, (double)maxIndex, true, [ & ]( auto acc ) { return (double)argmax<acc>( p1, count ); } );
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "reduce.hpp"
+// Reductions, this source file is compiled for AVX2 + FMA3.
+
+template<int accumulators>
+float squaredL2Distance( const float* p1, const float* p2, size_t count )
+{
+	return avx_reduce_multi<SquaredL2Op, accumulators>( p1, p2, count );
+}
+
+template<int accumulators>
+float l1Distance( const float* p1, const float* p2, size_t count )
+{
+	return avx_reduce_multi<L1Op, accumulators>( p1, p2, count );
+}
+
+template<int accumulators>
+float sumFloats( const float* p, size_t count )
+{
+	return avx_reduce_multi<SumOp, accumulators>( p, p, count );
+}
+
+template<int accumulators>
+float minimum( const float* p, size_t count )
+{
+	return avx_reduce_multi<MinOp, accumulators>( p, p, count );
+}
+
+template<int accumulators>
+float maximum( const float* p, size_t count )
+{
+	return avx_reduce_multi<MaxOp, accumulators>( p, p, count );
+}
+
+template<int accumulators>
+size_t argmax( const float* p, size_t count )
+{
+	return avx_reduce_multi<ArgMaxOp, accumulators>( p, p, count );
+}
+
+#define INSTANTIATE( N )                                                              \
+	template float squaredL2Distance<N>( const float* p1, const float* p2, size_t count ); \
+	template float l1Distance<N>( const float* p1, const float* p2, size_t count );        \
+	template float sumFloats<N>( const float* p, size_t count );                           \
+	template float minimum<N>( const float* p, size_t count );                             \
+	template float maximum<N>( const float* p, size_t count );                             \
+	template size_t argmax<N>( const float* p, size_t count )
+INSTANTIATE( 1 );
+INSTANTIATE( 2 );
+INSTANTIATE( 3 );
+INSTANTIATE( 4 );
+#undef INSTANTIATE
@@ -0,0 +1,191 @@
+#pragma once
+#include "vertical.hpp"
+// Reductions over one or two float arrays, generalizing avx_vertical_multi. Requires AVX2 + FMA3.
+//
+// An operation is a class with these members:
+// binary: true when the operation reads both arrays, false when it only reads the first one
+// Acc: type of the accumulators, Result: type of the result
+// identity(): initial value of the accumulators
+// combine( acc, a, b, index ): accumulate 8 elements. `index` has positions of these elements in the arrays, only argmax needs them.
+// blend( acc, updated, mask ): keep the accumulator in the lanes where the mask is zero, for the masked remainder
+// merge( x, y ): combine 2 accumulators
+// horizontal( acc ): reduce the lanes of the accumulator into the result
+
+// Base for the operations which accumulate a single vector of floats
+struct VectorReduction
+{
+	using Acc = __m256;
+	using Result = float;
+
+	static __forceinline Acc blend( Acc acc, Acc updated, __m256 mask )
+	{
+		return _mm256_blendv_ps( acc, updated, mask );
+	}
+};
+
+// Base for the operations which add up the values. The dot product is not here, avx_vertical_multi computes it.
+struct SumReduction : VectorReduction
+{
+	static __forceinline Acc identity() { return _mm256_setzero_ps(); }
+	static __forceinline Acc merge( Acc x, Acc y ) { return _mm256_add_ps( x, y ); }
+	static __forceinline Result horizontal( Acc acc ) { return hadd_ps( acc ); }
+};
+
+// Sum of ( a - b )^2
+struct SquaredL2Op : SumReduction
+{
+	static constexpr bool binary = true;
+	static __forceinline Acc combine( Acc acc, __m256 a, __m256 b, __m256i )
+	{
+		const __m256 diff = _mm256_sub_ps( a, b );
+		return _mm256_fmadd_ps( diff, diff, acc );
+	}
+};
+
+// Sum of | a - b |
+struct L1Op : SumReduction
+{
+	static constexpr bool binary = true;
+	static __forceinline Acc combine( Acc acc, __m256 a, __m256 b, __m256i )
+	{
+		// Absolute value clears the sign bit
+		const __m256 diff = _mm256_sub_ps( a, b );
+		return _mm256_add_ps( acc, _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), diff ) );
+	}
+};
+
+// Sum of a
+struct SumOp : SumReduction
+{
+	static constexpr bool binary = false;
+	static __forceinline Acc combine( Acc acc, __m256 a, __m256, __m256i ) { return _mm256_add_ps( acc, a ); }
+};
+
+// Minimum of a. minps returns the second operand when any of them is NaN, the NaNs are skipped.
+struct MinOp : VectorReduction
+{
+	static constexpr bool binary = false;
+	static __forceinline Acc identity() { return _mm256_set1_ps( std::numeric_limits<float>::infinity() ); }
+	static __forceinline Acc combine( Acc acc, __m256 a, __m256, __m256i ) { return _mm256_min_ps( a, acc ); }
+	static __forceinline Acc merge( Acc x, Acc y ) { return _mm256_min_ps( x, y ); }
+	static __forceinline Result horizontal( Acc acc ) { return hmin_ps( acc ); }
+};
+
+// Maximum of a, skipping NaNs
+struct MaxOp : VectorReduction
+{
+	static constexpr bool binary = false;
+	static __forceinline Acc identity() { return _mm256_set1_ps( -std::numeric_limits<float>::infinity() ); }
+	static __forceinline Acc combine( Acc acc, __m256 a, __m256, __m256i ) { return _mm256_max_ps( a, acc ); }
+	static __forceinline Acc merge( Acc x, Acc y ) { return _mm256_max_ps( x, y ); }
+	static __forceinline Result horizontal( Acc acc ) { return hmax_ps( acc ); }
+};
+
+// Index of the first maximum element. The indices are tracked in int32 lanes, the arrays must be shorter than 2^31 elements.
+struct ArgMaxOp
+{
+	static constexpr bool binary = false;
+	struct Acc
+	{
+		__m256 value;
+		__m256i index;
+	};
+	using Result = size_t;
+
+	static __forceinline Acc identity()
+	{
+		return Acc{ MaxOp::identity(), _mm256_setzero_si256() };
+	}
+
+	static __forceinline Acc combine( Acc acc, __m256 a, __m256, __m256i index )
+	{
+		// Strictly greater, the first of the equal elements wins
+		const __m256 greater = _mm256_cmp_ps( a, acc.value, _CMP_GT_OQ );
+		return blend( acc, Acc{ a, index }, greater );
+	}
+
+	static __forceinline Acc blend( Acc acc, Acc updated, __m256 mask )
+	{
+		acc.value = _mm256_blendv_ps( acc.value, updated.value, mask );
+		acc.index = _mm256_castps_si256( _mm256_blendv_ps( _mm256_castsi256_ps( acc.index ), _mm256_castsi256_ps( updated.index ), mask ) );
+		return acc;
+	}
+
+	static __forceinline Acc merge( Acc x, Acc y )
+	{
+		// Take y when it's greater, or equal with smaller index
+		const __m256 greater = _mm256_cmp_ps( y.value, x.value, _CMP_GT_OQ );
+		const __m256 equal = _mm256_cmp_ps( y.value, x.value, _CMP_EQ_OQ );
+		const __m256 smallerIndex = _mm256_castsi256_ps( _mm256_cmpgt_epi32( x.index, y.index ) );
+		return blend( x, y, _mm256_or_ps( greater, _mm256_and_ps( equal, smallerIndex ) ) );
+	}
+
+	static __forceinline Result horizontal( Acc acc )
+	{
+		// Find the maximum, then the smallest index among the lanes which have it
+		const __m256 max = _mm256_set1_ps( hmax_ps( acc.value ) );
+		const __m256 isMax = _mm256_cmp_ps( acc.value, max, _CMP_EQ_OQ );
+		__m256i idx = _mm256_castps_si256( _mm256_blendv_ps( _mm256_castsi256_ps( _mm256_set1_epi32( INT_MAX ) ), _mm256_castsi256_ps( acc.index ), isMax ) );
+		__m128i i4 = _mm_min_epi32( _mm256_castsi256_si128( idx ), _mm256_extracti128_si256( idx, 1 ) );
+		i4 = _mm_min_epi32( i4, _mm_shuffle_epi32( i4, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		i4 = _mm_min_epi32( i4, _mm_shuffle_epi32( i4, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		const int result = _mm_cvtsi128_si32( i4 );
+		// All elements are NaN or -inf, or the array is empty
+		return ( result == INT_MAX ) ? 0 : (size_t)result;
+	}
+};
+
+// Run the reduction over the arrays, with the specified count of independent accumulators.
+// Unary operations ignore the second array, pass the first one twice.
+template<class Op, int accumulators>
+__forceinline typename Op::Result avx_reduce_multi( const float* p1, const float* p2, size_t count )
+{
+	static_assert( accumulators > 0 && accumulators <= 4 );
+	constexpr int valuesPerLoop = accumulators * 8;
+	const size_t remainder = count % valuesPerLoop;
+	const float* const p1End = p1 + ( count - remainder );
+
+	// The index vectors are only used by argmax, compilers drop them for other operations.
+	typename Op::Acc acc[ accumulators ];
+	for( int i = 0; i < accumulators; i++ )
+		acc[ i ] = Op::identity();
+	__m256i index = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+
+	const auto loadSecond = []( const float* p )
+	{
+		if constexpr( Op::binary )
+			return _mm256_loadu_ps( p );
+		else
+			return _mm256_setzero_ps();
+	};
+
+	for( ; p1 < p1End; p1 += valuesPerLoop, p2 += valuesPerLoop )
+	{
+		for( int i = 0; i < accumulators; i++ )
+		{
+			const __m256i idx = _mm256_add_epi32( index, _mm256_set1_epi32( i * 8 ) );
+			acc[ i ] = Op::combine( acc[ i ], _mm256_loadu_ps( p1 + i * 8 ), loadSecond( p2 + i * 8 ), idx );
+		}
+		index = _mm256_add_epi32( index, _mm256_set1_epi32( valuesPerLoop ) );
+	}
+
+	// Up to 3 remaining complete vectors, then the remaining 1-7 floats with masked loads.
+	// The masked out lanes keep their accumulated values, zeros would break min and max.
+	size_t rem = remainder;
+	for( ; rem >= 8; rem -= 8, p1 += 8, p2 += 8 )
+	{
+		acc[ 0 ] = Op::combine( acc[ 0 ], _mm256_loadu_ps( p1 ), loadSecond( p2 ), index );
+		index = _mm256_add_epi32( index, _mm256_set1_epi32( 8 ) );
+	}
+	if( rem > 0 )
+	{
+		const __m256i mask = remainderMask( rem );
+		const __m256 a = _mm256_maskload_ps( p1, mask );
+		const __m256 b = Op::binary ? _mm256_maskload_ps( p2, mask ) : _mm256_setzero_ps();
+		acc[ 0 ] = Op::blend( acc[ 0 ], Op::combine( acc[ 0 ], a, b, index ), _mm256_castsi256_ps( mask ) );
+	}
+
+	for( int i = 1; i < accumulators; i++ )
+		acc[ 0 ] = Op::merge( acc[ 0 ], acc[ i ] );
+	return Op::horizontal( acc[ 0 ] );
+}
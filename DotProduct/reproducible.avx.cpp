@@ -0,0 +1,124 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "reproducible.hpp"
+// Reproducible dot product, AVX version. This source file is compiled for AVX.
+
+// 4 exact products of the floats, in double precision
+__forceinline __m256d products4( const float* p1, const float* p2 )
+{
+	return _mm256_mul_pd( _mm256_cvtps_pd( _mm_loadu_ps( p1 ) ), _mm256_cvtps_pd( _mm_loadu_ps( p2 ) ) );
+}
+
+__forceinline double hadd_pd( __m256d v )
+{
+	const __m128d r2 = _mm_add_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+	return _mm_cvtsd_f64( _mm_add_sd( r2, _mm_unpackhi_pd( r2, r2 ) ) );
+}
+
+__forceinline double hmax_pd( __m256d v )
+{
+	const __m128d r2 = _mm_max_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+	return _mm_cvtsd_f64( _mm_max_sd( r2, _mm_unpackhi_pd( r2, r2 ) ) );
+}
+
+// Extract 2 levels of 4 products, add them to the accumulators
+__forceinline void extract4( __m256d x, __m256d sigmaHigh, __m256d sigmaLow, __m256d& high, __m256d& low )
+{
+	const __m256d q = _mm256_sub_pd( _mm256_add_pd( sigmaHigh, x ), sigmaHigh );
+	const __m256d r = _mm256_sub_pd( x, q );
+	high = _mm256_add_pd( high, q );
+	low = _mm256_add_pd( low, _mm256_sub_pd( _mm256_add_pd( sigmaLow, r ), sigmaLow ) );
+}
+
+template<int accumulators>
+__forceinline void avx_reproducible_chunk( const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins )
+{
+	const size_t countVectors = count - count % 4;
+
+	// The first pass finds the maximum. x - x is zero for finite products, and NaN for infinities and NaNs; the sum of them detects special values.
+	const __m256d absMask = _mm256_castsi256_pd( _mm256_set1_epi64x( INT64_MAX ) );
+	__m256d maxAbs = _mm256_setzero_pd();
+	__m256d special = _mm256_setzero_pd();
+	for( size_t i = 0; i < countVectors; i += 4 )
+	{
+		const __m256d x = products4( p1 + i, p2 + i );
+		maxAbs = _mm256_max_pd( maxAbs, _mm256_and_pd( x, absMask ) );
+		special = _mm256_add_pd( special, _mm256_sub_pd( x, x ) );
+	}
+	double m = hmax_pd( maxAbs );
+	double s = hadd_pd( special );
+	for( size_t i = countVectors; i < count; i++ )
+	{
+		const double x = (double)p1[ i ] * (double)p2[ i ];
+		m = std::max( m, std::abs( x ) );
+		s += x - x;
+	}
+	if( 0 != s || s != s )
+	{
+		// Rare case, the scalar version separates the special values from the finite ones
+		reproducibleChunkScalar( p1, p2, count, lengthExponent, bins );
+		return;
+	}
+	if( 0 == m )
+		return;
+
+	// The second pass extracts the products into `accumulators` independent pairs of sums. All of these sums are exact, their count doesn't affect the result.
+	const ReproducibleSigma sigma{ m, lengthExponent };
+	const __m256d sigmaHigh = _mm256_set1_pd( sigma.high );
+	const __m256d sigmaLow = _mm256_set1_pd( sigma.low );
+	__m256d high[ accumulators ], low[ accumulators ];
+	for( int a = 0; a < accumulators; a++ )
+		high[ a ] = low[ a ] = _mm256_setzero_pd();
+
+	constexpr size_t valuesPerLoop = accumulators * 4;
+	size_t i = 0;
+	for( ; i + valuesPerLoop <= count; i += valuesPerLoop )
+		for( int a = 0; a < accumulators; a++ )
+			extract4( products4( p1 + i + a * 4, p2 + i + a * 4 ), sigmaHigh, sigmaLow, high[ a ], low[ a ] );
+	for( ; i < countVectors; i += 4 )
+		extract4( products4( p1 + i, p2 + i ), sigmaHigh, sigmaLow, high[ 0 ], low[ 0 ] );
+
+	for( int a = 1; a < accumulators; a++ )
+	{
+		high[ 0 ] = _mm256_add_pd( high[ 0 ], high[ a ] );
+		low[ 0 ] = _mm256_add_pd( low[ 0 ], low[ a ] );
+	}
+	double h = hadd_pd( high[ 0 ] );
+	double l = hadd_pd( low[ 0 ] );
+	for( ; i < count; i++ )
+		reproducibleExtract( (double)p1[ i ] * (double)p2[ i ], sigma, h, l );
+	bins.high[ sigma.bin ] += h;
+	bins.low[ sigma.bin ] += l;
+}
+
+template<int accumulators>
+static void avx_reproducible( const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins )
+{
+	for( size_t i = 0; i < count; i += reproducibleChunk )
+		avx_reproducible_chunk<accumulators>( p1 + i, p2 + i, std::min( reproducibleChunk, count - i ), lengthExponent, bins );
+}
+
+void avxReproducibleChunks( int accumulators, const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins )
+{
+	switch( accumulators )
+	{
+	case 1:
+		avx_reproducible<1>( p1, p2, count, lengthExponent, bins );
+		return;
+	case 2:
+		avx_reproducible<2>( p1, p2, count, lengthExponent, bins );
+		return;
+	case 3:
+		avx_reproducible<3>( p1, p2, count, lengthExponent, bins );
+		return;
+	default:
+		avx_reproducible<4>( p1, p2, count, lengthExponent, bins );
+		return;
+	}
+}
+
+template<>
+float dotProduct<eDotProductAlgorithm::AvxReproducible>( const float* p1, const float* p2, size_t count )
+{
+	return reproducibleDotProduct( p1, p2, count, eInstructionSet::Avx, 4, 1 );
+}
@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "threadPool.h"
+
+// 16M floats, 64MB per vector
+constexpr size_t reproducibleDefaultLength = 16 * 1024 * 1024;
+constexpr int reproducibleRepeats = 5;
+static const size_t s_reproducibleThreads[] = { 1, 2, 3, 7, 16 };
+
+static uint32_t floatBits( float f )
+{
+	uint32_t u;
+	memcpy( &u, &f, 4 );
+	return u;
+}
+
+// The optional argument is the length
+int benchmarkReproducible( int argc, const char* argv[] )
+{
+	size_t length = reproducibleDefaultLength;
+	if( !parseLength( argc, argv, length ) )
+		return 2;
+
+	// Negate every third element of one vector, for some cancellation in the sum.
+	auto v1 = alignedArray<float>( length );
+	auto v2 = alignedArray<float>( length );
+	fillRandomVector( true, v1.get(), length, 11 );
+	fillRandomVector( true, v2.get(), length, 12 );
+	for( size_t i = 0; i < length; i += 3 )
+		v1[ i ] = -v1[ i ];
+	const float* const p1 = v1.get();
+	const float* const p2 = v2.get();
+
+	// Every combination of the instruction set, accumulators and threads must produce the same bits
+	std::vector<eInstructionSet> isas{ eInstructionSet::Sse2 };
+	if( isSupported( eInstructionSet::Avx ) )
+		isas.push_back( eInstructionSet::Avx );
+	const float expected = reproducibleDotProduct( p1, p2, length, eInstructionSet::Sse2, 1, 1 );
+	int combinations = 0, mismatches = 0;
+	for( eInstructionSet isa : isas )
+		for( int acc = 1; acc <= 4; acc++ )
+			for( size_t threads : s_reproducibleThreads )
+			{
+				const float result = reproducibleDotProduct( p1, p2, length, isa, acc, threads );
+				combinations++;
+				if( floatBits( result ) == floatBits( expected ) )
+					continue;
+				mismatches++;
+				printf( "Mismatch: %s, %i accumulators, %i threads: %.9g, expected %.9g\n", instructionSetName( isa ), acc, (int)threads, (double)result, (double)expected );
+			}
+	const long double reference = referenceDotProduct( p1, p2, length );
+	printf( "Reproducible result %.9g, relative error %g; %i combinations of instruction set, accumulators and threads, %i mismatches\n",
+		(double)expected, (double)( std::abs( (long double)expected - reference ) / std::abs( reference ) ), combinations, mismatches );
+
+	// For comparison, the conventional kernels disagree with each other in the last bits
+	if( isSupported( eInstructionSet::Avx2 ) )
+	{
+		printf( "Conventional kernels:" );
+		for( eDotProductAlgorithm algo : { eDotProductAlgorithm::AvxVerticalFma, eDotProductAlgorithm::AvxVerticalFma2, eDotProductAlgorithm::AvxVerticalFma4, eDotProductAlgorithm::ParallelAvxFma4 } )
+			printf( " %s %.9g;", algorithmName( algo ), (double)dotProductFunc( algo )( p1, p2, length ) );
+		printf( "\n" );
+	}
+
+	// Throughput relative to AvxVerticalFma4, or the fastest algorithm this CPU supports
+	const eDotProductAlgorithm baseline = isSupported( eInstructionSet::Avx2 ) ? eDotProductAlgorithm::AvxVerticalFma4 : fastestAlgorithm();
+	const pfnDotProduct pfnBaseline = dotProductFunc( baseline );
+	volatile float sink;
+	const double usBaseline = bestTime( reproducibleRepeats, [ & ]() { sink = pfnBaseline( p1, p2, length ); } );
+	const double bytes = (double)length * 8;
+	printf( "%s: %g us, %.1f GB/s\n", algorithmName( baseline ), usBaseline, bytes / usBaseline * 1E-3 );
+	const size_t threadsCount = ThreadPool::shared().threadsCount();
+	for( eInstructionSet isa : isas )
+		for( size_t threads : { (size_t)1, threadsCount } )
+		{
+			const double us = bestTime( reproducibleRepeats, [ & ]() { sink = reproducibleDotProduct( p1, p2, length, isa, 4, threads ); } );
+			printf( "Reproducible %s, 4 accumulators, %i threads: %g us, %.1f GB/s, %.2f of %s throughput\n",
+				instructionSetName( isa ), (int)threads, us, bytes / us * 1E-3, usBaseline / us, algorithmName( baseline ) );
+			if( threadsCount == 1 )
+				break;
+		}
+	return 0 == mismatches ? 0 : 1;
+}
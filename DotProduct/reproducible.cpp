@@ -0,0 +1,164 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "reproducible.hpp"
+#include "threadPool.h"
+// Reproducible dot product, SSE2 version and the dispatcher. This source file is compiled for the baseline AMD64 instruction set.
+
+// 2 exact products of the floats, in double precision
+__forceinline __m128d products2( const float* p1, const float* p2 )
+{
+	const __m128d a = _mm_cvtps_pd( _mm_castpd_ps( _mm_load_sd( (const double*)p1 ) ) );
+	const __m128d b = _mm_cvtps_pd( _mm_castpd_ps( _mm_load_sd( (const double*)p2 ) ) );
+	return _mm_mul_pd( a, b );
+}
+
+__forceinline double hadd_pd( __m128d v )
+{
+	return _mm_cvtsd_f64( _mm_add_sd( v, _mm_unpackhi_pd( v, v ) ) );
+}
+
+__forceinline double hmax_pd( __m128d v )
+{
+	return _mm_cvtsd_f64( _mm_max_sd( v, _mm_unpackhi_pd( v, v ) ) );
+}
+
+// Extract 2 levels of 2 products, add them to the accumulators
+__forceinline void extract2( __m128d x, __m128d sigmaHigh, __m128d sigmaLow, __m128d& high, __m128d& low )
+{
+	const __m128d q = _mm_sub_pd( _mm_add_pd( sigmaHigh, x ), sigmaHigh );
+	const __m128d r = _mm_sub_pd( x, q );
+	high = _mm_add_pd( high, q );
+	low = _mm_add_pd( low, _mm_sub_pd( _mm_add_pd( sigmaLow, r ), sigmaLow ) );
+}
+
+// Same algorithm as avx_reproducible_chunk, 2 lanes instead of 4
+template<int accumulators>
+__forceinline void sse_reproducible_chunk( const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins )
+{
+	const size_t countVectors = count - count % 2;
+
+	const __m128d absMask = _mm_castsi128_pd( _mm_set1_epi64x( INT64_MAX ) );
+	__m128d maxAbs = _mm_setzero_pd();
+	__m128d special = _mm_setzero_pd();
+	for( size_t i = 0; i < countVectors; i += 2 )
+	{
+		const __m128d x = products2( p1 + i, p2 + i );
+		maxAbs = _mm_max_pd( maxAbs, _mm_and_pd( x, absMask ) );
+		special = _mm_add_pd( special, _mm_sub_pd( x, x ) );
+	}
+	double m = hmax_pd( maxAbs );
+	double s = hadd_pd( special );
+	if( countVectors < count )
+	{
+		const double x = (double)p1[ countVectors ] * (double)p2[ countVectors ];
+		m = std::max( m, std::abs( x ) );
+		s += x - x;
+	}
+	if( 0 != s || s != s )
+	{
+		reproducibleChunkScalar( p1, p2, count, lengthExponent, bins );
+		return;
+	}
+	if( 0 == m )
+		return;
+
+	const ReproducibleSigma sigma{ m, lengthExponent };
+	const __m128d sigmaHigh = _mm_set1_pd( sigma.high );
+	const __m128d sigmaLow = _mm_set1_pd( sigma.low );
+	__m128d high[ accumulators ], low[ accumulators ];
+	for( int a = 0; a < accumulators; a++ )
+		high[ a ] = low[ a ] = _mm_setzero_pd();
+
+	constexpr size_t valuesPerLoop = accumulators * 2;
+	size_t i = 0;
+	for( ; i + valuesPerLoop <= count; i += valuesPerLoop )
+		for( int a = 0; a < accumulators; a++ )
+			extract2( products2( p1 + i + a * 2, p2 + i + a * 2 ), sigmaHigh, sigmaLow, high[ a ], low[ a ] );
+	for( ; i < countVectors; i += 2 )
+		extract2( products2( p1 + i, p2 + i ), sigmaHigh, sigmaLow, high[ 0 ], low[ 0 ] );
+
+	for( int a = 1; a < accumulators; a++ )
+	{
+		high[ 0 ] = _mm_add_pd( high[ 0 ], high[ a ] );
+		low[ 0 ] = _mm_add_pd( low[ 0 ], low[ a ] );
+	}
+	double h = hadd_pd( high[ 0 ] );
+	double l = hadd_pd( low[ 0 ] );
+	if( i < count )
+		reproducibleExtract( (double)p1[ i ] * (double)p2[ i ], sigma, h, l );
+	bins.high[ sigma.bin ] += h;
+	bins.low[ sigma.bin ] += l;
+}
+
+template<int accumulators>
+static void sse_reproducible( const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins )
+{
+	for( size_t i = 0; i < count; i += reproducibleChunk )
+		sse_reproducible_chunk<accumulators>( p1 + i, p2 + i, std::min( reproducibleChunk, count - i ), lengthExponent, bins );
+}
+
+void sseReproducibleChunks( int accumulators, const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins )
+{
+	switch( accumulators )
+	{
+	case 1:
+		sse_reproducible<1>( p1, p2, count, lengthExponent, bins );
+		return;
+	case 2:
+		sse_reproducible<2>( p1, p2, count, lengthExponent, bins );
+		return;
+	case 3:
+		sse_reproducible<3>( p1, p2, count, lengthExponent, bins );
+		return;
+	default:
+		sse_reproducible<4>( p1, p2, count, lengthExponent, bins );
+		return;
+	}
+}
+
+float reproducibleDotProduct( const float* p1, const float* p2, size_t count, eInstructionSet isa, int accumulators, size_t threads )
+{
+	const int lengthExponent = reproducibleLengthExponent( count );
+	auto chunks = [ = ]( const float* a, const float* b, size_t length, ReproducibleBins& bins )
+	{
+		if( isa >= eInstructionSet::Avx )
+			avxReproducibleChunks( accumulators, a, b, length, lengthExponent, bins );
+		else
+			sseReproducibleChunks( accumulators, a, b, length, lengthExponent, bins );
+	};
+
+	// The pieces consist of complete chunks, the boundaries of the chunks don't depend on the count of threads
+	const size_t totalChunks = ( count + reproducibleChunk - 1 ) / reproducibleChunk;
+	const size_t pieces = std::max( std::min( threads, totalChunks ), (size_t)1 );
+	if( 1 == pieces )
+	{
+		ReproducibleBins bins;
+		chunks( p1, p2, count, bins );
+		return bins.result();
+	}
+
+	const size_t piece = ( totalChunks + pieces - 1 ) / pieces * reproducibleChunk;
+	std::vector<ReproducibleBins> bins( pieces );
+	ThreadPool::shared().parallelFor( pieces, [ & ]( size_t i )
+	{
+		const size_t offset = i * piece;
+		if( offset < count )
+			chunks( p1 + offset, p2 + offset, std::min( piece, count - offset ), bins[ i ] );
+	} );
+	for( size_t i = 1; i < pieces; i++ )
+		bins[ 0 ].add( bins[ i ] );
+	return bins[ 0 ].result();
+}
+
+template<>
+float dotProduct<eDotProductAlgorithm::SseReproducible>( const float* p1, const float* p2, size_t count )
+{
+	return reproducibleDotProduct( p1, p2, count, eInstructionSet::Sse2, 2, 1 );
+}
+
+template<>
+float dotProduct<eDotProductAlgorithm::ParallelReproducible>( const float* p1, const float* p2, size_t count )
+{
+	const eInstructionSet isa = std::min( supportedInstructionSet(), eInstructionSet::Avx );
+	return reproducibleDotProduct( p1, p2, count, isa, 4, ThreadPool::shared().threadsCount() );
+}
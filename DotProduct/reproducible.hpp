@@ -0,0 +1,121 @@
+#pragma once
+// Reproducible dot product: bitwise identical results regardless of the instruction set, count of accumulators, and how the work is split across threads.
+// The vectors are split into chunks of a fixed size. Products of floats are exact in double precision. For every chunk, the products are pre-rounded
+// to 2 levels of fixed-point bins with the extraction q = ( sigma + x ) - sigma, where sigma is a power of 2 which only depends on the maximum product in the chunk,
+// and the total length. The sigma is large enough for all sums of the extracted values to be exact, and exact sums don't depend on the order of additions.
+// This is the pre-rounding technique from Demmel and Nguyen, "Fast Reproducible Floating-Point Summation", also used in ReproBLAS.
+// The extraction requires IEEE semantics of additions: it doesn't work with -ffast-math, /fp:fast, or other options which allow reassociation.
+
+// Count of floats in a chunk. This constant is a part of the definition of the result, changing it changes the results.
+constexpr size_t reproducibleChunk = 2048;
+
+// The sigmas are aligned to multiples of this count of bits, chunks with similar maximums use the same bins
+constexpr int reproducibleBinBits = 8;
+// Products of finite floats are in [ 2^-298, 2^256 ) interval
+constexpr int reproducibleMinExponent = -304;
+constexpr int reproducibleMaxExponent = 256;
+constexpr int reproducibleBinsCount = ( reproducibleMaxExponent - reproducibleMinExponent ) / reproducibleBinBits + 1;
+
+// Exact sums of the extracted values, for both levels of every bin
+struct ReproducibleBins
+{
+	double high[ reproducibleBinsCount ] = {};
+	double low[ reproducibleBinsCount ] = {};
+	// Sum of infinite and NaN products, also independent of the order: it's either zero, infinity, or NaN
+	double special = 0;
+
+	// Add the sums of another instance, exactly
+	void add( const ReproducibleBins& that )
+	{
+		for( int i = 0; i < reproducibleBinsCount; i++ )
+		{
+			high[ i ] += that.high[ i ];
+			low[ i ] += that.low[ i ];
+		}
+		special += that.special;
+	}
+
+	// Add the bins from the largest one, in the fixed order
+	float result() const
+	{
+		if( 0 != special || special != special )
+			return (float)special;
+		double sum = 0;
+		for( int i = reproducibleBinsCount - 1; i >= 0; i-- )
+			sum += high[ i ];
+		for( int i = reproducibleBinsCount - 1; i >= 0; i-- )
+			sum += low[ i ];
+		return (float)sum;
+	}
+};
+
+// The smallest e such as count <= 2^e
+inline int reproducibleLengthExponent( size_t count )
+{
+	int e = 0;
+	while( ( (size_t)1 << e ) < count )
+		e++;
+	return e;
+}
+
+// Bin index and both sigmas for a chunk with the specified maximum absolute product
+struct ReproducibleSigma
+{
+	int bin;
+	double high, low;
+
+	ReproducibleSigma( double maxAbs, int lengthExponent )
+	{
+		// maxAbs < 2^e, rounded up to the grid of the bins
+		int e;
+		frexp( maxAbs, &e );
+		bin = ( e - reproducibleMinExponent + reproducibleBinBits - 1 ) / reproducibleBinBits;
+		const int exponent = reproducibleMinExponent + bin * reproducibleBinBits;
+		// With |x| <= 2^exponent and at most 2^lengthExponent values, every extracted value is a multiple of ulp( sigma ) / 2,
+		// and the magnitude of their sum stays below sigma / 2, that's why the sums are exact.
+		high = ldexp( 1.0, exponent + lengthExponent + 2 );
+		// The remainders of the first level are at most sigma * 2^-53
+		low = ldexp( 1.0, exponent + 2 * lengthExponent + 4 - 53 );
+	}
+};
+
+// Extract 2 levels of the value, add them to the sums
+__forceinline void reproducibleExtract( double x, const ReproducibleSigma& sigma, double& high, double& low )
+{
+	const double q = ( sigma.high + x ) - sigma.high;
+	const double r = x - q;
+	high += q;
+	low += ( sigma.low + r ) - sigma.low;
+}
+
+// Scalar version for a single chunk, also handles infinite and NaN products
+inline void reproducibleChunkScalar( const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins )
+{
+	double maxAbs = 0;
+	for( size_t i = 0; i < count; i++ )
+	{
+		const double x = (double)p1[ i ] * (double)p2[ i ];
+		if( std::isfinite( x ) )
+			maxAbs = std::max( maxAbs, std::abs( x ) );
+		else
+			bins.special += x;
+	}
+	if( 0 == maxAbs )
+		return;
+
+	const ReproducibleSigma sigma{ maxAbs, lengthExponent };
+	double high = 0, low = 0;
+	for( size_t i = 0; i < count; i++ )
+	{
+		const double x = (double)p1[ i ] * (double)p2[ i ];
+		if( std::isfinite( x ) )
+			reproducibleExtract( x, sigma, high, low );
+	}
+	bins.high[ sigma.bin ] += high;
+	bins.low[ sigma.bin ] += low;
+}
+
+// Process the complete chunks and the remainder of the piece of the vectors, with SSE2 or AVX.
+// The accumulators count is 1-4, the lengthExponent is for the complete vectors.
+void sseReproducibleChunks( int accumulators, const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins );
+void avxReproducibleChunks( int accumulators, const float* p1, const float* p2, size_t count, int lengthExponent, ReproducibleBins& bins );
@@ -19,4 +19,29 @@ float dotProduct<eDotProductAlgorithm::ScalarDouble>( const float* p1, const flo
 	for( ; p1 < p1End; p1++, p2++ )
 		result += p1[ 0 ] * p2[ 0 ];
 	return (float)result;
-}
\ No newline at end of file
+}
+
+float sparseDotProductScalar( const uint32_t* indices, const float* values, size_t count, const float* dense )
+{
+	float result = 0;
+	for( size_t i = 0; i < count; i++ )
+		result += values[ i ] * dense[ indices[ i ] ];
+	return result;
+}
+
+float sparseSparseDotProductScalar( const uint32_t* indices1, const float* values1, size_t count1, const uint32_t* indices2, const float* values2, size_t count2 )
+{
+	// Merge the sorted index lists
+	float result = 0;
+	size_t i = 0, j = 0;
+	while( i < count1 && j < count2 )
+	{
+		const uint32_t a = indices1[ i ];
+		const uint32_t b = indices2[ j ];
+		if( a == b )
+			result += values1[ i ] * values2[ j ];
+		i += ( a <= b ) ? 1 : 0;
+		j += ( b <= a ) ? 1 : 0;
+	}
+	return result;
+}
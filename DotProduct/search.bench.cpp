@@ -0,0 +1,68 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "search.h"
+#include "threadPool.h"
+
+// 1M rows * 64 floats = 256MB matrix
+constexpr size_t searchDefaultRows = 1024 * 1024;
+constexpr size_t searchLength = 64;
+constexpr size_t searchK = 10;
+constexpr int searchQueries = 20;
+
+// Exhaustive search with a loop over dotProduct, the reference for the recall
+static std::vector<uint32_t> exhaustiveSearch( const float* matrix, size_t rows, const float* query, size_t k )
+{
+	std::vector<std::pair<float, uint32_t>> scores( rows );
+	for( size_t i = 0; i < rows; i++ )
+		scores[ i ] = std::make_pair( dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( matrix + i * searchLength, query, searchLength ), (uint32_t)i );
+	k = std::min( k, rows );
+	std::partial_sort( scores.begin(), scores.begin() + k, scores.end(), []( const auto& a, const auto& b ) { return a.first > b.first; } );
+	std::vector<uint32_t> result( k );
+	for( size_t i = 0; i < k; i++ )
+		result[ i ] = scores[ i ].second;
+	return result;
+}
+
+// The optional argument is count of rows
+int benchmarkSearch( int argc, const char* argv[] )
+{
+	size_t rows = searchDefaultRows;
+	if( !parseLength( argc, argv, rows ) )
+		return 2;
+
+	auto matrix = alignedArray<float>( rows * searchLength );
+	auto queries = alignedArray<float>( searchQueries * searchLength );
+	fillRandomVector( true, matrix.get(), rows * searchLength, 11 );
+	fillRandomVector( true, queries.get(), searchQueries * searchLength, 12 );
+
+	std::vector<std::vector<sSearchResult>> results( searchQueries );
+	auto runQueries = [ & ]( bool multithreaded )
+	{
+		const Stopwatch stopwatch;
+		for( int q = 0; q < searchQueries; q++ )
+			results[ q ] = searchTopK( matrix.get(), rows, searchLength, queries.get() + q * searchLength, searchK, multithreaded );
+		return stopwatch.elapsedMicroseconds();
+	};
+	// Warm up, also launches the thread pool
+	runQueries( true );
+	const double usSingle = runQueries( false );
+	const double usMulti = runQueries( true );
+
+	// Scores computed by different kernels differ in rounding, the recall may be slightly less than 100% when there're nearly equal scores
+	size_t found = 0, total = 0;
+	for( int q = 0; q < searchQueries; q++ )
+	{
+		const std::vector<uint32_t> reference = exhaustiveSearch( matrix.get(), rows, queries.get() + q * searchLength, searchK );
+		for( const sSearchResult& r : results[ q ] )
+			found += ( std::find( reference.begin(), reference.end(), r.index ) != reference.end() ) ? 1 : 0;
+		total += reference.size();
+	}
+
+	const double matrixBytes = (double)( rows * searchLength * 4 );
+	printf( "%i rows * %i floats, top %i, %i queries\n", (int)rows, (int)searchLength, (int)searchK, searchQueries );
+	printf( "Single-threaded: %.1f queries/second, %.1f GB/s\n", searchQueries * 1E6 / usSingle, matrixBytes * searchQueries / usSingle * 1E-3 );
+	printf( "%i threads: %.1f queries/second, %.1f GB/s\n", (int)ThreadPool::shared().threadsCount(), searchQueries * 1E6 / usMulti, matrixBytes * searchQueries / usMulti * 1E-3 );
+	printf( "Recall versus exhaustive AvxVerticalFma4 loop: %.2f%%\n", 100.0 * (double)found / (double)total );
+	printf( "Best result of the first query: row %i, score %g\n", (int)results[ 0 ][ 0 ].index, (double)results[ 0 ][ 0 ].score );
+	return 0;
+}
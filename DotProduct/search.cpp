@@ -0,0 +1,129 @@
+#include "stdafx.h"
+#include "search.h"
+#include "threadPool.h"
+// Brute-force top-k search, this source file is compiled for AVX2 + FMA3.
+
+// Scores are computed for this many rows at once, the buffer stays in L1D cache
+constexpr size_t searchBlockRows = 256;
+
+// Order of the heap: the worst result on top. For equal scores, the smaller index is better.
+static bool isBetter( const sSearchResult& a, const sSearchResult& b )
+{
+	if( a.score != b.score )
+		return a.score > b.score;
+	return a.index < b.index;
+}
+
+// Index of the lowest set bit, the argument must not be zero. TZCNT instruction is from BMI1, which is not a part of AVX2.
+inline uint32_t lowestSetBit( uint32_t mask )
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward( &index, mask );
+	return index;
+#else
+	return (uint32_t)__builtin_ctz( mask );
+#endif
+}
+
+TopK::TopK( size_t k ) :
+	k( k )
+{
+	heap.reserve( k );
+}
+
+void TopK::push( float score, uint32_t index )
+{
+	if( 0 == k )
+		return;
+	const sSearchResult r{ score, index };
+	if( heap.size() < k )
+	{
+		heap.push_back( r );
+		std::push_heap( heap.begin(), heap.end(), isBetter );
+	}
+	else
+	{
+		if( !isBetter( r, heap.front() ) )
+			return;
+		std::pop_heap( heap.begin(), heap.end(), isBetter );
+		heap.back() = r;
+		std::push_heap( heap.begin(), heap.end(), isBetter );
+	}
+	if( heap.size() == k )
+		threshold = heap.front().score;
+}
+
+void TopK::pushBlock( const float* scores, size_t count, uint32_t firstIndex )
+{
+	size_t i = 0;
+	for( ; i + 8 <= count; i += 8 )
+	{
+		// Scores equal to the threshold may still win by the smaller index, that's why greater or equal
+		const __m256 s = _mm256_loadu_ps( scores + i );
+		uint32_t mask = (uint32_t)_mm256_movemask_ps( _mm256_cmp_ps( s, _mm256_set1_ps( threshold ), _CMP_GE_OQ ) );
+		while( 0 != mask )
+		{
+			const uint32_t lane = lowestSetBit( mask );
+			push( scores[ i + lane ], firstIndex + (uint32_t)i + lane );
+			mask &= mask - 1;
+		}
+	}
+	for( ; i < count; i++ )
+	{
+		if( scores[ i ] >= threshold )
+			push( scores[ i ], firstIndex + (uint32_t)i );
+	}
+}
+
+void TopK::merge( const TopK& that )
+{
+	for( const sSearchResult& r : that.heap )
+		push( r.score, r.index );
+}
+
+std::vector<sSearchResult> TopK::sorted() const
+{
+	std::vector<sSearchResult> result = heap;
+	std::sort( result.begin(), result.end(), isBetter );
+	return result;
+}
+
+// Search the rows [ begin .. end ) of the matrix
+static void searchSlice( const float* matrix, size_t begin, size_t end, size_t length, const float* query, TopK& topk )
+{
+	alignas( 32 ) std::array<float, searchBlockRows> scores;
+	for( size_t row = begin; row < end; row += searchBlockRows )
+	{
+		const size_t rows = std::min( searchBlockRows, end - row );
+		matrixVectorProduct( matrix + row * length, rows, query, length, scores.data() );
+		topk.pushBlock( scores.data(), rows, (uint32_t)row );
+	}
+}
+
+std::vector<sSearchResult> searchTopK( const float* matrix, size_t rows, size_t length, const float* query, size_t k, bool multithreaded )
+{
+	assert( rows <= UINT_MAX );
+	TopK result{ k };
+	if( !multithreaded )
+	{
+		searchSlice( matrix, 0, rows, length, query, result );
+		return result.sorted();
+	}
+
+	// One slice of the rows per thread, each with its own heap
+	ThreadPool& pool = ThreadPool::shared();
+	const size_t threads = pool.threadsCount();
+	const size_t slice = ( rows + threads - 1 ) / threads;
+	std::vector<TopK> heaps( threads, TopK{ k } );
+	pool.parallelFor( threads, [ & ]( size_t i )
+	{
+		const size_t begin = std::min( i * slice, rows );
+		const size_t end = std::min( begin + slice, rows );
+		searchSlice( matrix, begin, end, length, query, heaps[ i ] );
+	} );
+
+	for( const TopK& h : heaps )
+		result.merge( h );
+	return result.sorted();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "../common.h"
+
+// A row of the matrix found by the search
+struct sSearchResult
+{
+	float score;
+	uint32_t index;
+};
+
+// Keeps k results with the largest scores seen so far, in a min-heap.
+// Most scores are below the k-th best one; pushBlock rejects them 8 at a time with SIMD comparisons, and only updates the heap for the rest.
+class TopK
+{
+	std::vector<sSearchResult> heap;
+	size_t k;
+	// The smallest score in the heap once it's full, -inf before that
+	float threshold = -std::numeric_limits<float>::infinity();
+
+public:
+	TopK( size_t k );
+
+	// Add a single result
+	void push( float score, uint32_t index );
+
+	// Add scores of sequential rows, starting from the specified index. Requires AVX2.
+	void pushBlock( const float* scores, size_t count, uint32_t firstIndex );
+
+	// Add the results of another instance
+	void merge( const TopK& that );
+
+	// Get the results sorted by descending scores
+	std::vector<sSearchResult> sorted() const;
+};
+
+// Find k rows of the row-major matrix with the largest dot products with the query, sorted by descending scores.
+// The rows are scored in blocks with matrixVectorProduct function. When multithreaded, each thread of the pool searches a slice of the rows with its own heap, they're merged at the end.
+// Requires AVX2 + FMA3, rows count must be less than 2^32.
+std::vector<sSearchResult> searchTopK( const float* matrix, size_t rows, size_t length, const float* query, size_t k, bool multithreaded );
@@ -0,0 +1,51 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// 16k pairs, up to 6MB for both arrays of 48-float vectors; larger batches are bound by memory bandwidth in both versions
+constexpr size_t soaDefaultPairs = 16 * 1024;
+constexpr int soaRepeats = 5;
+static const size_t s_soaLengths[] = { 8, 12, 16, 24, 32, 48 };
+
+// The optional argument is count of pairs
+int benchmarkSoa( int argc, const char* argv[] )
+{
+	size_t pairs = soaDefaultPairs;
+	if( !parseLength( argc, argv, pairs ) )
+		return 2;
+
+	printf( "%i pairs of vectors, time per dot product\n", (int)pairs );
+	for( size_t length : s_soaLengths )
+	{
+		const size_t count = pairs * length;
+		const size_t soaCount = ( pairs + 7 ) / 8 * 8 * length;
+		auto a = alignedArray<float>( count );
+		auto b = alignedArray<float>( count );
+		auto aSoa = alignedArray<float>( soaCount );
+		auto bSoa = alignedArray<float>( soaCount );
+		fillRandomVector( true, a.get(), count, 11 );
+		fillRandomVector( true, b.get(), count, 12 );
+		std::vector<float> resultLoop( pairs ), resultSoa( pairs );
+
+		const double usLoop = bestTime( soaRepeats, [ & ]()
+		{
+			for( size_t i = 0; i < pairs; i++ )
+				resultLoop[ i ] = dotProduct<eDotProductAlgorithm::AvxVerticalFma>( a.get() + i * length, b.get() + i * length, length );
+		} );
+		const double usTranspose = bestTime( soaRepeats, [ & ]()
+		{
+			transposeToSoA( a.get(), pairs, length, aSoa.get() );
+			transposeToSoA( b.get(), pairs, length, bSoa.get() );
+		} );
+		const double usSoa = bestTime( soaRepeats, [ & ]() { dotProductsSoA( aSoa.get(), bSoa.get(), pairs, length, resultSoa.data() ); } );
+
+		// Different order of additions, the results are slightly different
+		double maxError = 0;
+		for( size_t i = 0; i < pairs; i++ )
+			maxError = std::max( maxError, std::abs( (double)resultLoop[ i ] - (double)resultSoa[ i ] ) / std::abs( (double)resultLoop[ i ] ) );
+
+		const double ns = 1E3 / (double)pairs;
+		printf( "%i floats: loop over AvxVerticalFma %.2f ns, SoA %.2f ns, %.2fx faster; transpose of both %.2f ns, with the transpose %.2fx faster; maximum relative difference %g\n",
+			(int)length, usLoop * ns, usSoa * ns, usLoop / usSoa, usTranspose * ns, usLoop / ( usSoa + usTranspose ), maxError );
+	}
+	return 0;
+}
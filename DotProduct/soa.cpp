@@ -0,0 +1,153 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Batches of independent dot products in structure-of-arrays layout, this source file is compiled for AVX2 + FMA3.
+
+// Transpose 4x4 blocks within 16-byte lanes of 4 registers
+__forceinline void transpose4x4Lanes( __m256& r0, __m256& r1, __m256& r2, __m256& r3 )
+{
+	const __m256 t0 = _mm256_unpacklo_ps( r0, r1 );
+	const __m256 t1 = _mm256_unpackhi_ps( r0, r1 );
+	const __m256 t2 = _mm256_unpacklo_ps( r2, r3 );
+	const __m256 t3 = _mm256_unpackhi_ps( r2, r3 );
+	r0 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+	r1 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+	r2 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+	r3 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+}
+
+// Transpose 8x8 block of floats in 8 registers
+__forceinline void transpose8x8( __m256& r0, __m256& r1, __m256& r2, __m256& r3, __m256& r4, __m256& r5, __m256& r6, __m256& r7 )
+{
+	transpose4x4Lanes( r0, r1, r2, r3 );
+	transpose4x4Lanes( r4, r5, r6, r7 );
+	// Swap the 16-byte halves across registers
+	const __m256 s0 = r0, s1 = r1, s2 = r2, s3 = r3;
+	r0 = _mm256_permute2f128_ps( s0, r4, 0x20 );
+	r1 = _mm256_permute2f128_ps( s1, r5, 0x20 );
+	r2 = _mm256_permute2f128_ps( s2, r6, 0x20 );
+	r3 = _mm256_permute2f128_ps( s3, r7, 0x20 );
+	r4 = _mm256_permute2f128_ps( s0, r4, 0x31 );
+	r5 = _mm256_permute2f128_ps( s1, r5, 0x31 );
+	r6 = _mm256_permute2f128_ps( s2, r6, 0x31 );
+	r7 = _mm256_permute2f128_ps( s3, r7, 0x31 );
+}
+
+// Load 4 floats from 2 rows into the halves of the register. The insert from memory runs on the load ports, unlike vperm2f128 which competes with the shuffles.
+__forceinline __m256 loadHalves( const float* low, const float* high )
+{
+	return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( low ) ), _mm_loadu_ps( high ), 1 );
+}
+
+// Transpose a complete 8x8 tile: 8 rows with the specified stride, into 8 aligned vectors
+__forceinline void transposeTile( const float* src, size_t stride, float* dst )
+{
+	// Rows 0-3 go to the lower halves, rows 4-7 to the upper ones; then 4x4 transposes within the lanes complete the 8x8 one.
+	__m256 r0 = loadHalves( src, src + 4 * stride );
+	__m256 r1 = loadHalves( src + stride, src + 5 * stride );
+	__m256 r2 = loadHalves( src + 2 * stride, src + 6 * stride );
+	__m256 r3 = loadHalves( src + 3 * stride, src + 7 * stride );
+	__m256 r4 = loadHalves( src + 4, src + 4 * stride + 4 );
+	__m256 r5 = loadHalves( src + stride + 4, src + 5 * stride + 4 );
+	__m256 r6 = loadHalves( src + 2 * stride + 4, src + 6 * stride + 4 );
+	__m256 r7 = loadHalves( src + 3 * stride + 4, src + 7 * stride + 4 );
+	transpose4x4Lanes( r0, r1, r2, r3 );
+	transpose4x4Lanes( r4, r5, r6, r7 );
+	_mm256_store_ps( dst, r0 );
+	_mm256_store_ps( dst + 8, r1 );
+	_mm256_store_ps( dst + 16, r2 );
+	_mm256_store_ps( dst + 24, r3 );
+	_mm256_store_ps( dst + 32, r4 );
+	_mm256_store_ps( dst + 40, r5 );
+	_mm256_store_ps( dst + 48, r6 );
+	_mm256_store_ps( dst + 56, r7 );
+}
+
+void transposeToSoA( const float* src, size_t pairs, size_t length, float* dst )
+{
+	const size_t blocks = ( pairs + 7 ) / 8;
+	for( size_t b = 0; b < blocks; b++ )
+	{
+		// The rows past the end of the source are zeros
+		const size_t rows = std::min( pairs - b * 8, (size_t)8 );
+		const float* const block = src + b * 8 * length;
+		float* const dstBlock = dst + b * 8 * length;
+		size_t j = 0;
+		if( 8 == rows )
+		{
+			for( ; j + 8 <= length; j += 8 )
+				transposeTile( block + j, length, dstBlock + j * 8 );
+		}
+		for( ; j < length; j += 8 )
+		{
+			// Incomplete tiles: masked loads for the remaining 1-7 columns, zeros for the missing rows
+			const size_t columns = std::min( length - j, (size_t)8 );
+			const __m256i mask = remainderMask( columns );
+			__m256 r[ 8 ];
+			for( size_t i = 0; i < 8; i++ )
+				r[ i ] = ( i < rows ) ? _mm256_maskload_ps( block + i * length + j, mask ) : _mm256_setzero_ps();
+			transpose8x8( r[ 0 ], r[ 1 ], r[ 2 ], r[ 3 ], r[ 4 ], r[ 5 ], r[ 6 ], r[ 7 ] );
+			// Element j of the row i goes to dstBlock[ j * 8 + i ]
+			for( size_t i = 0; i < columns; i++ )
+				_mm256_store_ps( dstBlock + ( j + i ) * 8, r[ i ] );
+		}
+	}
+}
+
+// Dot products of `blocks` sequential blocks of 8 pairs, one accumulator per block.
+// Lane i of every accumulator belongs to pair i of the block, there're no horizontal additions.
+template<int blocks>
+__forceinline void soaBlocks( const float* a, const float* b, size_t length, __m256* result )
+{
+	static_assert( blocks > 0 && blocks <= 4 );
+	const size_t blockStride = length * 8;
+	__m256 dot[ blocks ];
+	for( int i = 0; i < blocks; i++ )
+		dot[ i ] = _mm256_setzero_ps();
+	for( size_t j = 0; j < blockStride; j += 8 )
+	{
+		for( int i = 0; i < blocks; i++ )
+		{
+			const size_t offset = i * blockStride + j;
+			dot[ i ] = fmadd_ps<true>( _mm256_load_ps( a + offset ), _mm256_load_ps( b + offset ), dot[ i ] );
+		}
+	}
+	for( int i = 0; i < blocks; i++ )
+		result[ i ] = dot[ i ];
+}
+
+void dotProductsSoA( const float* a, const float* b, size_t pairs, size_t length, float* result )
+{
+	// 4 blocks at a time, 4 independent FMA chains hide the latency
+	const size_t blockStride = length * 8;
+	size_t pair = 0;
+	__m256 dot[ 4 ];
+	for( ; pair + 32 <= pairs; pair += 32, a += blockStride * 4, b += blockStride * 4 )
+	{
+		soaBlocks<4>( a, b, length, dot );
+		for( int i = 0; i < 4; i++ )
+			_mm256_storeu_ps( result + pair + i * 8, dot[ i ] );
+	}
+
+	// The remaining 1-4 blocks, the last one may be incomplete
+	const size_t remainingBlocks = ( pairs - pair + 7 ) / 8;
+	switch( remainingBlocks )
+	{
+	case 0:
+		return;
+	case 1:
+		soaBlocks<1>( a, b, length, dot );
+		break;
+	case 2:
+		soaBlocks<2>( a, b, length, dot );
+		break;
+	case 3:
+		soaBlocks<3>( a, b, length, dot );
+		break;
+	case 4:
+		soaBlocks<4>( a, b, length, dot );
+		break;
+	}
+	for( size_t i = 0; pair < pairs; i++, pair += 8 )
+		_mm256_maskstore_ps( result + pair, remainderMask( std::min( pairs - pair, (size_t)8 ) ), dot[ i ] );
+}
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// 1M floats = 4MB dense vector, larger than L2 cache of most CPUs
+constexpr size_t sparseDefaultLength = 1024 * 1024;
+constexpr int sparseRepeats = 10;
+
+// Random sparse vector with the specified density, indices are sorted
+static void makeSparseVector( size_t length, double density, uint32_t seed, std::vector<uint32_t>& indices, std::vector<float>& values )
+{
+	std::mt19937 rng{ seed };
+	std::bernoulli_distribution include{ density };
+	std::uniform_real_distribution<float> value{ 0.0f, 1.0f };
+	indices.clear();
+	values.clear();
+	for( size_t i = 0; i < length; i++ )
+	{
+		if( !include( rng ) )
+			continue;
+		indices.push_back( (uint32_t)i );
+		values.push_back( value( rng ) );
+	}
+}
+
+// The optional argument is length of the dense vector
+int benchmarkSparse( int argc, const char* argv[] )
+{
+	size_t length = sparseDefaultLength;
+	if( !parseLength( argc, argv, length ) )
+		return 2;
+	auto dense = alignedArray<float>( length );
+	fillRandomVector( true, dense.get(), length, 11 );
+	auto densified = alignedArray<float>( length );
+
+	// Densifying is memset plus scatter of the non-zero elements, then the dense dot product
+	printf( "Dense vector of %i floats, times in microseconds\n", (int)length );
+	printf( "Density\tNon-zeros\tScalar\tGather\tDense\tDensify + dense\tMax relative difference\n" );
+	const double densities[] = { 0.001, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0 };
+	std::vector<uint32_t> indices;
+	std::vector<float> values;
+	for( double density : densities )
+	{
+		makeSparseVector( length, density, 12, indices, values );
+		const size_t count = indices.size();
+		float resultScalar = 0, resultGather = 0, resultDense = 0;
+
+		const double usScalar = bestTime( sparseRepeats, [ & ]()
+		{
+			resultScalar = sparseDotProductScalar( indices.data(), values.data(), count, dense.get() );
+		} );
+		const double usGather = bestTime( sparseRepeats, [ & ]()
+		{
+			resultGather = sparseDotProduct( indices.data(), values.data(), count, dense.get() );
+		} );
+
+		auto densify = [ & ]()
+		{
+			memset( densified.get(), 0, length * 4 );
+			for( size_t i = 0; i < count; i++ )
+				densified[ indices[ i ] ] = values[ i ];
+		};
+		const double usDensify = bestTime( sparseRepeats, densify );
+		const double usDense = bestTime( sparseRepeats, [ & ]()
+		{
+			resultDense = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( densified.get(), dense.get(), length );
+		} );
+
+		// Different order of additions, the results are slightly different
+		const double maxResult = std::max( std::abs( (double)resultScalar ), 1E-30 );
+		const double difference = std::max( std::abs( (double)resultGather - resultScalar ), std::abs( (double)resultDense - resultScalar ) ) / maxResult;
+		printf( "%g%%\t%i\t%g\t%g\t%g\t%g\t%g\n", density * 100, (int)count, usScalar, usGather, usDense, usDensify + usDense, difference );
+	}
+	return 0;
+}
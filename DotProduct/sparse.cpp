@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Sparse vectors, this source file is compiled for AVX2 + FMA3.
+
+// Load 8 indices and gather the corresponding elements of the dense vector.
+// The gather instruction takes signed 32-bit indices, the indices must be less than 2^31.
+__forceinline __m256 gather( const float* dense, const uint32_t* indices )
+{
+	const __m256i idx = _mm256_loadu_si256( ( const __m256i* )indices );
+	return _mm256_i32gather_ps( dense, idx, 4 );
+}
+
+// Same structure as avx_vertical_multi<4>, one of the loads is a gather
+__forceinline float avx_sparse_multi( const uint32_t* indices, const float* values, size_t count, const float* dense )
+{
+	constexpr int valuesPerLoop = 32;
+	const size_t remainder = count % valuesPerLoop;
+	const float* const valuesEnd = values + ( count - remainder );
+
+	__m256 dot0 = _mm256_setzero_ps();
+	__m256 dot1 = _mm256_setzero_ps();
+	__m256 dot2 = _mm256_setzero_ps();
+	__m256 dot3 = _mm256_setzero_ps();
+	for( ; values < valuesEnd; values += valuesPerLoop, indices += valuesPerLoop )
+	{
+		dot0 = _mm256_fmadd_ps( _mm256_loadu_ps( values ), gather( dense, indices ), dot0 );
+		dot1 = _mm256_fmadd_ps( _mm256_loadu_ps( values + 8 ), gather( dense, indices + 8 ), dot1 );
+		dot2 = _mm256_fmadd_ps( _mm256_loadu_ps( values + 16 ), gather( dense, indices + 16 ), dot2 );
+		dot3 = _mm256_fmadd_ps( _mm256_loadu_ps( values + 24 ), gather( dense, indices + 24 ), dot3 );
+	}
+
+	// Up to 3 remaining complete vectors, then the remaining 1-7 elements
+	const size_t remainingVectors = remainder / 8;
+	if( remainingVectors > 0 )
+		dot0 = _mm256_fmadd_ps( _mm256_loadu_ps( values ), gather( dense, indices ), dot0 );
+	if( remainingVectors > 1 )
+		dot1 = _mm256_fmadd_ps( _mm256_loadu_ps( values + 8 ), gather( dense, indices + 8 ), dot1 );
+	if( remainingVectors > 2 )
+		dot2 = _mm256_fmadd_ps( _mm256_loadu_ps( values + 16 ), gather( dense, indices + 16 ), dot2 );
+	const size_t remainingValues = remainder % 8;
+	if( remainingValues > 0 )
+	{
+		values += remainingVectors * 8;
+		indices += remainingVectors * 8;
+		// Masked gather doesn't access memory in the masked out lanes, same as masked loads
+		const __m256i mask = remainderMask( remainingValues );
+		const __m256i idx = _mm256_maskload_epi32( ( const int* )indices, mask );
+		const __m256 d = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), dense, idx, _mm256_castsi256_ps( mask ), 4 );
+		dot3 = _mm256_fmadd_ps( _mm256_maskload_ps( values, mask ), d, dot3 );
+	}
+
+	const __m256 dot01 = _mm256_add_ps( dot0, dot1 );
+	const __m256 dot23 = _mm256_add_ps( dot2, dot3 );
+	return hadd_ps( _mm256_add_ps( dot01, dot23 ) );
+}
+
+float sparseDotProduct( const uint32_t* indices, const float* values, size_t count, const float* dense )
+{
+	return avx_sparse_multi( indices, values, count, dense );
+}
+
+// Compare the indices of the first block with the second one rotated by r lanes, accumulate products of the matching elements
+template<int r>
+__forceinline __m256 intersectRotation( __m256i idx1, __m256 val1, __m256i idx2, __m256 val2, __m256 acc )
+{
+	const __m256i perm = _mm256_setr_epi32( r, ( r + 1 ) % 8, ( r + 2 ) % 8, ( r + 3 ) % 8, ( r + 4 ) % 8, ( r + 5 ) % 8, ( r + 6 ) % 8, ( r + 7 ) % 8 );
+	const __m256 eq = _mm256_castsi256_ps( _mm256_cmpeq_epi32( idx1, _mm256_permutevar8x32_epi32( idx2, perm ) ) );
+	const __m256 v2 = _mm256_permutevar8x32_ps( val2, perm );
+	// Zero values of the first block where indices don't match, then multiply + accumulate
+	return _mm256_fmadd_ps( _mm256_and_ps( eq, val1 ), v2, acc );
+}
+
+// Dot product of 2 sparse vectors by intersecting the sorted index lists.
+// Compares all pairs of 8x8 blocks of the indices, as 8 rotations of the second block, then advances the block with the smaller last index.
+// Indices are unique within a vector, every element of the first block matches at most 1 rotation.
+__forceinline float avx_sparse_sparse( const uint32_t* indices1, const float* values1, size_t count1, const uint32_t* indices2, const float* values2, size_t count2 )
+{
+	// 2 accumulators, the even and odd rotations. The chain of 8 dependent FMAs would be the bottleneck otherwise.
+	__m256 acc0 = _mm256_setzero_ps();
+	__m256 acc1 = _mm256_setzero_ps();
+	size_t i = 0, j = 0;
+	while( i + 8 <= count1 && j + 8 <= count2 )
+	{
+		const __m256i idx1 = _mm256_loadu_si256( ( const __m256i* )( indices1 + i ) );
+		const __m256i idx2 = _mm256_loadu_si256( ( const __m256i* )( indices2 + j ) );
+		const __m256 val1 = _mm256_loadu_ps( values1 + i );
+		const __m256 val2 = _mm256_loadu_ps( values2 + j );
+		acc0 = intersectRotation<0>( idx1, val1, idx2, val2, acc0 );
+		acc1 = intersectRotation<1>( idx1, val1, idx2, val2, acc1 );
+		acc0 = intersectRotation<2>( idx1, val1, idx2, val2, acc0 );
+		acc1 = intersectRotation<3>( idx1, val1, idx2, val2, acc1 );
+		acc0 = intersectRotation<4>( idx1, val1, idx2, val2, acc0 );
+		acc1 = intersectRotation<5>( idx1, val1, idx2, val2, acc1 );
+		acc0 = intersectRotation<6>( idx1, val1, idx2, val2, acc0 );
+		acc1 = intersectRotation<7>( idx1, val1, idx2, val2, acc1 );
+
+		const uint32_t last1 = indices1[ i + 7 ];
+		const uint32_t last2 = indices2[ j + 7 ];
+		i += ( last1 <= last2 ) ? 8 : 0;
+		j += ( last2 <= last1 ) ? 8 : 0;
+	}
+	float result = hadd_ps( _mm256_add_ps( acc0, acc1 ) );
+
+	// Less than 8 indices remain in one of the lists. None of the pairs after the current positions were compared yet, merge them with scalar code.
+	result += sparseSparseDotProductScalar( indices1 + i, values1 + i, count1 - i, indices2 + j, values2 + j, count2 - j );
+	return result;
+}
+
+float sparseSparseDotProduct( const uint32_t* indices1, const float* values1, size_t count1, const uint32_t* indices2, const float* values2, size_t count2 )
+{
+	return avx_sparse_sparse( indices1, values1, count1, indices2, values2, count2 );
+}
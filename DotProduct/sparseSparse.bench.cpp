@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// By default, both sparse vectors have 64k non-zero elements
+constexpr size_t sparseSparseDefaultCount = 64 * 1024;
+// The indices are in [ 0 .. count * ratio ) interval, i.e. [ 0 .. 512k ) by default
+constexpr size_t sparseSparseUniverseRatio = 8;
+constexpr int sparseSparseRepeats = 10;
+
+struct SparseVector
+{
+	std::vector<uint32_t> indices;
+	std::vector<float> values;
+};
+
+// Make the indices sorted, and random values
+static void finishSparseVector( SparseVector& vec, std::mt19937& rng )
+{
+	std::sort( vec.indices.begin(), vec.indices.end() );
+	std::uniform_real_distribution<float> value{ 0.0f, 1.0f };
+	vec.values.resize( vec.indices.size() );
+	for( float& f : vec.values )
+		f = value( rng );
+}
+
+// The optional argument is count of non-zero elements in both vectors
+int benchmarkSparseSparse( int argc, const char* argv[] )
+{
+	size_t count = sparseSparseDefaultCount;
+	if( !parseLength( argc, argv, count ) )
+		return 2;
+	const size_t universe = count * sparseSparseUniverseRatio;
+	auto dense1 = alignedArray<float>( universe );
+	auto dense2 = alignedArray<float>( universe );
+
+	// Random distinct indices
+	std::mt19937 rng{ 11 };
+	std::vector<uint32_t> shuffled( universe );
+	for( size_t i = 0; i < universe; i++ )
+		shuffled[ i ] = (uint32_t)i;
+	std::shuffle( shuffled.begin(), shuffled.end(), rng );
+
+	printf( "%i non-zero elements in both vectors, %i dense length, times in microseconds\n", (int)count, (int)universe );
+	printf( "Overlap\tScalar merge\tSIMD intersection\tDensify + dense\tMax relative difference\n" );
+	const double overlaps[] = { 0, 0.01, 0.1, 0.25, 0.5, 0.9, 1.0 };
+	for( double overlap : overlaps )
+	{
+		// The shared indices come first in the shuffled array, then unique indices of both vectors
+		const size_t shared = (size_t)std::lround( overlap * (double)count );
+		SparseVector v1, v2;
+		v1.indices.assign( shuffled.begin(), shuffled.begin() + count );
+		v2.indices.assign( shuffled.begin(), shuffled.begin() + shared );
+		v2.indices.insert( v2.indices.end(), shuffled.begin() + count, shuffled.begin() + ( count * 2 - shared ) );
+		finishSparseVector( v1, rng );
+		finishSparseVector( v2, rng );
+
+		float resultScalar = 0, resultSimd = 0, resultDense = 0;
+		const double usScalar = bestTime( sparseSparseRepeats, [ & ]()
+		{
+			resultScalar = sparseSparseDotProductScalar( v1.indices.data(), v1.values.data(), count, v2.indices.data(), v2.values.data(), count );
+		} );
+		const double usSimd = bestTime( sparseSparseRepeats, [ & ]()
+		{
+			resultSimd = sparseSparseDotProduct( v1.indices.data(), v1.values.data(), count, v2.indices.data(), v2.values.data(), count );
+		} );
+		const double usDense = bestTime( sparseSparseRepeats, [ & ]()
+		{
+			memset( dense1.get(), 0, universe * 4 );
+			memset( dense2.get(), 0, universe * 4 );
+			for( size_t i = 0; i < count; i++ )
+			{
+				dense1[ v1.indices[ i ] ] = v1.values[ i ];
+				dense2[ v2.indices[ i ] ] = v2.values[ i ];
+			}
+			resultDense = dotProduct<eDotProductAlgorithm::AvxVerticalFma4>( dense1.get(), dense2.get(), universe );
+		} );
+
+		// Different order of additions, the results are slightly different
+		const double maxResult = std::max( std::abs( (double)resultScalar ), 1E-30 );
+		double difference = std::max( std::abs( (double)resultSimd - resultScalar ), std::abs( (double)resultDense - resultScalar ) );
+		if( 0 != shared )
+			difference /= maxResult;
+		printf( "%g%%\t%g\t%g\t%g\t%g\n", overlap * 100, usScalar, usSimd, usDense, difference );
+	}
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+#include "streaming.h"
+
+static void printUsage()
+{
+	printf( "Usage: stream <path> [algorithm] [chunk] [buffers] [cold]: out-of-core dot product of 2 halves of the raw float32 file\n" );
+	printf( "algorithm is the number or auto, chunk is count of KB of each vector read at once, default 4096; buffers is 2 or more, default 2;\n" );
+	printf( "cold evicts the file from the page cache before every pass, to read it from the disk\n" );
+}
+
+static bool printError( const char* path, int err )
+{
+	if( 0 == err )
+		return false;
+	printf( "Unable to read the file \"%s\": %s\n", path, strerror( err ) );
+	return true;
+}
+
+int benchmarkStreaming( int argc, const char* argv[] )
+{
+	if( argc < 1 )
+	{
+		printUsage();
+		return 2;
+	}
+
+	const char* const path = argv[ 0 ];
+	sStreamingOptions options;
+	if( argc > 1 && 0 == strcmp( argv[ argc - 1 ], "cold" ) )
+	{
+		options.dropCache = true;
+		argc--;
+	}
+
+	int algoInt = (int)fastestAlgorithm();
+	if( argc > 1 && 0 != strcmp( argv[ 1 ], "auto" ) && ( !nonstd::atoi( argv[ 1 ], algoInt ) || algoInt < 0 || algoInt >= (int)eDotProductAlgorithm::valuesCount ) )
+	{
+		printUsage();
+		return 2;
+	}
+	const eDotProductAlgorithm algo = (eDotProductAlgorithm)algoInt;
+	if( !isSupported( requiredInstructionSet( algo ) ) )
+	{
+		printf( "%s requires %s\n", algorithmName( algo ), instructionSetName( requiredInstructionSet( algo ) ) );
+		return 3;
+	}
+
+	int chunkKb = 4096;
+	if( argc > 2 && ( !nonstd::atoi( argv[ 2 ], chunkKb ) || chunkKb <= 0 ) )
+	{
+		printUsage();
+		return 2;
+	}
+	options.chunkFloats = (size_t)chunkKb * 1024 / sizeof( float );
+	if( argc > 3 && ( !nonstd::atoi( argv[ 3 ], options.buffers ) || options.buffers < 2 ) )
+	{
+		printUsage();
+		return 2;
+	}
+	printf( "%s, chunks of %i KB * 2 vectors, %i buffers%s\n", algorithmName( algo ), chunkKb, options.buffers, options.dropCache ? ", cold page cache" : "" );
+
+	// Read the file without computing anything, with the same chunks and buffers. That's the upper bound of the streaming throughput.
+	float result;
+	sStreamingStats raw;
+	if( printError( path, streamingDotProduct( path, nullptr, options, result, raw ) ) )
+		return 4;
+	const double rawGbps = raw.bytes / raw.totalMicroseconds * 1E-3;
+	printf( "Raw read: %g us, %.2f GB/s\n", raw.totalMicroseconds, rawGbps );
+
+	// Same reads, overlapped with the dot product of the chunks
+	sStreamingStats stats;
+	if( printError( path, streamingDotProduct( path, dotProductFunc( algo ), options, result, stats ) ) )
+		return 4;
+	const double gbps = stats.bytes / stats.totalMicroseconds * 1E-3;
+	printf( "Streaming: %g us, %.2f GB/s, %.0f%% of the raw read bandwidth\n", stats.totalMicroseconds, gbps, 100.0 * gbps / rawGbps );
+	printf( "Reader thread: %g us in pread; compute thread: %g us computing, %g us waiting for data\n",
+		stats.readMicroseconds, stats.computeMicroseconds, stats.waitMicroseconds );
+	// Without the overlap, the total time would be the sum of reading and computing
+	printf( "Overlapped %.0f%% of the compute time with I/O\n",
+		100.0 * std::clamp( ( stats.readMicroseconds + stats.computeMicroseconds - stats.totalMicroseconds ) / stats.computeMicroseconds, 0.0, 1.0 ) );
+	printf( "Result: %g\n", (double)result );
+	return 0;
+}
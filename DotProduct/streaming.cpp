@@ -0,0 +1,206 @@
+#include "stdafx.h"
+#include "streaming.h"
+#ifdef __linux__
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#ifdef __linux__
+namespace
+{
+	// Read the complete range, retrying partial reads. Returns 0 or errno.
+	int readExact( int fd, void* dest, size_t length, uint64_t offset )
+	{
+		uint8_t* p = (uint8_t*)dest;
+		while( length > 0 )
+		{
+			const ssize_t cb = pread( fd, p, length, (off_t)offset );
+			if( cb < 0 )
+			{
+				if( EINTR == errno )
+					continue;
+				return errno;
+			}
+			if( 0 == cb )
+				return EIO;	// The file was truncated while reading
+			p += cb;
+			offset += (uint64_t)cb;
+			length -= (size_t)cb;
+		}
+		return 0;
+	}
+
+	// Read-only file descriptor, closed by the destructor
+	class FileHandle
+	{
+		int fd;
+
+	public:
+		FileHandle( const char* path ) :
+			fd( open( path, O_RDONLY ) ) { }
+		~FileHandle()
+		{
+			if( fd >= 0 )
+				close( fd );
+		}
+		FileHandle( const FileHandle& ) = delete;
+		void operator=( const FileHandle& ) = delete;
+
+		operator int() const
+		{
+			return fd;
+		}
+	};
+
+	// Ring of buffers shared by the reader and the computing threads.
+	// Chunk i goes to the buffer i % buffers, the reader waits for the buffer to be consumed before reusing it.
+	class ChunksRing
+	{
+		std::mutex mutex;
+		std::condition_variable cvFilled, cvConsumed;
+		// These fields are protected by the mutex
+		size_t filled = 0;
+		size_t consumed = 0;
+		int error = 0;
+
+	public:
+		const size_t buffers;
+
+		ChunksRing( size_t buffers ) :
+			buffers( buffers ) { }
+
+		// Reader thread: wait until the buffer for the chunk is no longer used by the computing thread
+		void waitForBuffer( size_t chunk )
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			cvConsumed.wait( lock, [ & ] { return chunk - consumed < buffers; } );
+		}
+
+		// Reader thread: the chunk is in the buffer, or the read failed with the error code
+		void setFilled( size_t chunk, int err )
+		{
+			{
+				const std::lock_guard<std::mutex> lock{ mutex };
+				filled = chunk + 1;
+				error = err;
+			}
+			cvFilled.notify_one();
+		}
+
+		// Computing thread: wait for the chunk to be read, returns the error code of the reader
+		int waitForChunk( size_t chunk )
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			cvFilled.wait( lock, [ & ] { return filled > chunk || 0 != error; } );
+			return error;
+		}
+
+		// Computing thread: the buffer of the chunk is free to be reused
+		void setConsumed( size_t chunk )
+		{
+			{
+				const std::lock_guard<std::mutex> lock{ mutex };
+				consumed = chunk + 1;
+			}
+			cvConsumed.notify_one();
+		}
+	};
+}
+#endif
+
+int streamingDotProduct( const char* path, pfnDotProduct pfn, const sStreamingOptions& options, float& result, sStreamingStats& stats )
+{
+	stats = sStreamingStats{};
+	result = 0;
+#ifdef __linux__
+	const Stopwatch stopwatch;
+	// Separate descriptors for the 2 vectors, the kernel tracks read-ahead state of each one, and detects 2 sequential streams
+	const FileHandle file1{ path }, file2{ path };
+	if( file1 < 0 || file2 < 0 )
+		return errno;
+
+	struct stat st;
+	if( 0 != fstat( file1, &st ) )
+		return errno;
+	const uint64_t count = (uint64_t)st.st_size / sizeof( float ) / 2;
+	if( 0 == count )
+		return EINVAL;
+	if( options.dropCache )
+	{
+		// The advice is not binding, ignoring the error
+		posix_fadvise( file1, 0, 0, POSIX_FADV_DONTNEED );
+	}
+	posix_fadvise( file1, 0, 0, POSIX_FADV_SEQUENTIAL );
+	posix_fadvise( file2, 0, 0, POSIX_FADV_SEQUENTIAL );
+
+	const size_t chunkFloats = (size_t)std::min( (uint64_t)std::max( options.chunkFloats, (size_t)1 ), count );
+	const size_t chunks = (size_t)( ( count + chunkFloats - 1 ) / chunkFloats );
+	const size_t buffersCount = (size_t)std::max( options.buffers, 1 );
+
+	// Every buffer contains a chunk of the first vector, followed by the same chunk of the second one
+	std::vector<std::unique_ptr<float[], details::AlignedDeleter>> buffers;
+	buffers.reserve( buffersCount );
+	for( size_t i = 0; i < buffersCount; i++ )
+		buffers.push_back( alignedArray<float>( chunkFloats * 2 ) );
+
+	ChunksRing ring{ buffersCount };
+	double readMicroseconds = 0;
+	std::thread reader{ [ & ]()
+	{
+		for( size_t i = 0; i < chunks; i++ )
+		{
+			ring.waitForBuffer( i );
+			const uint64_t offset = (uint64_t)i * chunkFloats;
+			const size_t length = (size_t)std::min( (uint64_t)chunkFloats, count - offset );
+			float* const dest = buffers[ i % buffersCount ].get();
+
+			const Stopwatch readStopwatch;
+			int err = readExact( file1, dest, length * sizeof( float ), offset * sizeof( float ) );
+			if( 0 == err )
+				err = readExact( file2, dest + chunkFloats, length * sizeof( float ), ( count + offset ) * sizeof( float ) );
+			readMicroseconds += readStopwatch.elapsedMicroseconds();
+
+			ring.setFilled( i, err );
+			if( 0 != err )
+				return;
+		}
+	} };
+
+	// Compute the chunks as soon as they arrive, the reader fills the other buffers meanwhile
+	double sum = 0;
+	int err = 0;
+	for( size_t i = 0; i < chunks; i++ )
+	{
+		const Stopwatch waitStopwatch;
+		err = ring.waitForChunk( i );
+		stats.waitMicroseconds += waitStopwatch.elapsedMicroseconds();
+		if( 0 != err )
+			break;
+
+		if( nullptr != pfn )
+		{
+			const Stopwatch computeStopwatch;
+			const uint64_t offset = (uint64_t)i * chunkFloats;
+			const size_t length = (size_t)std::min( (uint64_t)chunkFloats, count - offset );
+			const float* const p = buffers[ i % buffersCount ].get();
+			sum += pfn( p, p + chunkFloats, length );
+			stats.computeMicroseconds += computeStopwatch.elapsedMicroseconds();
+		}
+		ring.setConsumed( i );
+	}
+	reader.join();
+	if( 0 != err )
+		return err;
+
+	result = (float)sum;
+	stats.bytes = count * sizeof( float ) * 2;
+	stats.readMicroseconds = readMicroseconds;
+	stats.totalMicroseconds = stopwatch.elapsedMicroseconds();
+	return 0;
+#else
+	return ENOSYS;
+#endif
+}
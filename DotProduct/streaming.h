@@ -0,0 +1,30 @@
+#pragma once
+#include "../common.h"
+#include "dotproduct.h"
+
+// Out-of-core dot product of the 2 halves of a raw float32 file, same input as the file benchmark.
+// A reader thread copies fixed-size chunks of both vectors into a ring of aligned buffers with pread, while the calling thread computes the chunks read earlier.
+// Implemented on Linux. On other OSes the function fails with ENOSYS error code.
+struct sStreamingOptions
+{
+	// Count of floats of each vector in a chunk
+	size_t chunkFloats = 1024 * 1024;
+	// Count of buffers in the ring, 2 for double buffering, 3 for triple
+	int buffers = 2;
+	// posix_fadvise( POSIX_FADV_DONTNEED ) before reading: evict the file from the page cache, to measure reading it from the disk
+	bool dropCache = false;
+};
+
+struct sStreamingStats
+{
+	// Bytes read from the file
+	uint64_t bytes = 0;
+	// Total time, and the time the reader thread spent in pread calls
+	double totalMicroseconds = 0, readMicroseconds = 0;
+	// Time the computing thread spent waiting for the reader, and computing
+	double waitMicroseconds = 0, computeMicroseconds = 0;
+};
+
+// Compute the dot product with the function. With nullptr function only read the file, to measure the raw read bandwidth.
+// The partial sums of the chunks are accumulated in double precision. Returns 0 on success, or errno of the failed system call.
+int streamingDotProduct( const char* path, pfnDotProduct pfn, const sStreamingOptions& options, float& result, sStreamingStats& stats );
@@ -0,0 +1,109 @@
+#include "stdafx.h"
+#include "benchmarks.h"
+
+// Vector lengths from 1k floats = 8kb for both vectors which fits in L1D, up to 16M floats = 128MB which only fits in DRAM.
+constexpr size_t sweepMinLength = 1024;
+constexpr size_t sweepMaxLength = 16 * 1024 * 1024;
+constexpr int sweepDefaultRepeats = 50;
+// Short vectors are too fast for the clock, every sample runs the kernel at least this many times, and it reports the average.
+constexpr size_t sweepMinValuesPerSample = 256 * 1024;
+
+struct sSweepStats
+{
+	double minUs, medianUs, p99Us;
+};
+
+static sSweepStats measureSweep( pfnDotProduct pfn, const float* p1, const float* p2, size_t count, int repeats )
+{
+	const size_t callsPerSample = std::max( sweepMinValuesPerSample / count, (size_t)1 );
+	volatile float dot;
+
+	// Warm up caches, TLB, branch predictors, and the worker threads of the parallel version
+	for( size_t i = 0; i < callsPerSample * 2; i++ )
+		dot = pfn( p1, p2, count );
+
+	std::vector<double> samples( (size_t)repeats );
+	for( double& us : samples )
+	{
+		const Stopwatch stopwatch;
+		for( size_t i = 0; i < callsPerSample; i++ )
+			dot = pfn( p1, p2, count );
+		us = stopwatch.elapsedMicroseconds() / (double)callsPerSample;
+	}
+	(void)dot;
+
+	std::sort( samples.begin(), samples.end() );
+	sSweepStats res;
+	res.minUs = samples.front();
+	res.medianUs = samples[ samples.size() / 2 ];
+	// Nearest rank percentile
+	const size_t p99 = (size_t)std::ceil( 0.99 * (double)samples.size() ) - 1;
+	res.p99Us = samples[ p99 ];
+	return res;
+}
+
+// Arguments are optional: output format, "csv" or "json", and count of repetitions
+int benchmarkSweep( int argc, const char* argv[] )
+{
+	bool json = false;
+	if( argc > 0 )
+	{
+		if( 0 == strcmp( argv[ 0 ], "json" ) )
+			json = true;
+		else if( 0 != strcmp( argv[ 0 ], "csv" ) )
+		{
+			printf( "Invalid format \"%s\", must be csv or json\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+	int repeats = sweepDefaultRepeats;
+	if( argc > 1 && ( !nonstd::atoi( argv[ 1 ], repeats ) || repeats < 1 ) )
+	{
+		printf( "Invalid repetitions count \"%s\"\n", argv[ 1 ] );
+		return 2;
+	}
+
+	auto v1 = alignedArray<float>( sweepMaxLength );
+	auto v2 = alignedArray<float>( sweepMaxLength );
+	fillRandomVector( true, v1.get(), sweepMaxLength, 11 );
+	fillRandomVector( true, v2.get(), sweepMaxLength, 12 );
+
+	if( json )
+		printf( "[\n" );
+	else
+		printf( "algorithm,length,bytes,repetitions,min_us,median_us,p99_us,gb_per_sec,gflop_per_sec\n" );
+	bool first = true;
+
+	for( size_t count = sweepMinLength; count <= sweepMaxLength; count *= 4 )
+	{
+		for( uint8_t i = 0; i < (uint8_t)eDotProductAlgorithm::valuesCount; i++ )
+		{
+			const eDotProductAlgorithm algo = (eDotProductAlgorithm)i;
+			if( !isSupported( requiredInstructionSet( algo ) ) )
+				continue;
+			const sSweepStats stats = measureSweep( dotProductFunc( algo ), v1.get(), v2.get(), count, repeats );
+
+			// Both vectors are loaded once, every element costs a multiplication and an addition.
+			// The bandwidth and FLOPs are computed from the fastest time, the roofline is about the peak performance.
+			const double bytes = (double)( count * 8 );
+			const double gbps = bytes / stats.minUs * 1E-3;
+			const double gflops = (double)( count * 2 ) / stats.minUs * 1E-3;
+
+			if( json )
+			{
+				printf( "%s\t{ \"algorithm\": \"%s\", \"length\": %i, \"bytes\": %i, \"repetitions\": %i, \"min_us\": %g, \"median_us\": %g, \"p99_us\": %g, \"gb_per_sec\": %g, \"gflop_per_sec\": %g }",
+					first ? "" : ",\n", algorithmName( algo ), (int)count, (int)( count * 8 ), repeats, stats.minUs, stats.medianUs, stats.p99Us, gbps, gflops );
+			}
+			else
+			{
+				printf( "%s,%i,%i,%i,%g,%g,%g,%g,%g\n",
+					algorithmName( algo ), (int)count, (int)( count * 8 ), repeats, stats.minUs, stats.medianUs, stats.p99Us, gbps, gflops );
+			}
+			first = false;
+			fflush( stdout );
+		}
+	}
+	if( json )
+		printf( "\n]\n" );
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include "stdafx.h"
+#include "threadPool.h"
+
+ThreadPool::ThreadPool( size_t threads )
+{
+	if( 0 == threads )
+		threads = std::max( std::thread::hardware_concurrency(), 1u );
+	workers.reserve( threads - 1 );
+	for( size_t i = 1; i < threads; i++ )
+		workers.emplace_back( &ThreadPool::workerThread, this );
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		const std::lock_guard<std::mutex> lock{ mutex };
+		shuttingDown = true;
+	}
+	cvStart.notify_all();
+	for( std::thread& t : workers )
+		t.join();
+}
+
+void ThreadPool::runPieces( const std::function<void( size_t )>& func, size_t length )
+{
+	// Pieces are claimed dynamically, this way the threads which started earlier take more of them.
+	for( size_t i = nextIndex++; i < length; i = nextIndex++ )
+		func( i );
+}
+
+void ThreadPool::workerThread()
+{
+	uint64_t completedGeneration = 0;
+	while( true )
+	{
+		const std::function<void( size_t )>* func;
+		size_t length;
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			cvStart.wait( lock, [ & ] { return shuttingDown || generation != completedGeneration; } );
+			if( shuttingDown )
+				return;
+			completedGeneration = generation;
+			func = job;
+			length = jobLength;
+		}
+
+		runPieces( *func, length );
+
+		const std::lock_guard<std::mutex> lock{ mutex };
+		busyWorkers--;
+		if( 0 == busyWorkers )
+			cvFinish.notify_one();
+	}
+}
+
+void ThreadPool::parallelFor( size_t length, const std::function<void( size_t )>& func )
+{
+	if( workers.empty() || length < 2 )
+	{
+		// Nothing to parallelize
+		for( size_t i = 0; i < length; i++ )
+			func( i );
+		return;
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock{ mutex };
+		job = &func;
+		jobLength = length;
+		nextIndex = 0;
+		busyWorkers = workers.size();
+		generation++;
+	}
+	cvStart.notify_all();
+
+	runPieces( func, length );
+
+	std::unique_lock<std::mutex> lock{ mutex };
+	cvFinish.wait( lock, [ this ] { return 0 == busyWorkers; } );
+	job = nullptr;
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
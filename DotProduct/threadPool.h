@@ -0,0 +1,53 @@
+#pragma once
+#include "../common.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// A minimal pool of worker threads, runs the same function on many pieces of data in parallel.
+// The calling thread participates in the work, i.e. a pool of N threads only launches N-1 extra ones.
+// Not reentrant: only one thread at a time may call parallelFor method.
+class ThreadPool
+{
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable cvStart, cvFinish;
+
+	// The job being executed. These fields are protected by the mutex.
+	const std::function<void( size_t )>* job = nullptr;
+	size_t jobLength = 0;
+	uint64_t generation = 0;
+	size_t busyWorkers = 0;
+	bool shuttingDown = false;
+
+	// Index of the next piece of the job to be picked by any of the threads.
+	std::atomic_size_t nextIndex;
+
+	void workerThread();
+
+	void runPieces( const std::function<void( size_t )>& func, size_t length );
+
+public:
+
+	// Create the pool with the specified count of threads. Zero means use all hardware threads of the computer.
+	ThreadPool( size_t threads = 0 );
+	~ThreadPool();
+
+	ThreadPool( const ThreadPool& ) = delete;
+	void operator=( const ThreadPool& ) = delete;
+
+	// Count of threads including the calling one
+	size_t threadsCount() const
+	{
+		return workers.size() + 1;
+	}
+
+	// Call func( i ) for every i in [ 0 .. length ) interval, distributing these calls across the threads. Returns after all of them completed.
+	void parallelFor( size_t length, const std::function<void( size_t )>& func );
+
+	// The pool shared by the whole program, launched on first use.
+	static ThreadPool& shared();
+};
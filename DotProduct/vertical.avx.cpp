@@ -0,0 +1,16 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Versions without FMA which use 32-byte vectors, this source file is compiled for AVX
+
+template<>
+float dotProduct<eDotProductAlgorithm::AvxVertical>( const float* p1, const float* p2, size_t count )
+{
+	return avx_vertical<false>( p1, p2, count );
+}
+
+template<>
+float dotProduct<eDotProductAlgorithm::AvxVertical4>( const float* p1, const float* p2, size_t count )
+{
+	return avx_vertical_multi<4, false>( p1, p2, count );
+}
\ No newline at end of file
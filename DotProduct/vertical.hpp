@@ -0,0 +1,411 @@
+#pragma once
+// Templates of the vertical versions. They're instantiated in several *.cpp files, each of them is compiled for a different instruction set.
+// The kernels with a template count of accumulators keep them in small arrays, like avx_vertical_fixed below. The loops over these arrays have
+// compile-time trip count, compilers unroll them and keep the arrays in registers. Indexing them with a runtime value would spill them to memory.
+
+// ==== Some helper functions ====
+
+// Horizontal sum of 4 lanes of the vector
+__forceinline float hadd_ps( __m128 r4 )
+{
+	// Add 4 values into 2
+	const __m128 r2 = _mm_add_ps( r4, _mm_movehl_ps( r4, r4 ) );
+	// Add 2 lower values into the final result
+	const __m128 r1 = _mm_add_ss( r2, _mm_movehdup_ps( r2 ) );
+	// Return the lowest lane of the result vector.
+	// The intrinsic below compiles into noop, modern compilers return floats in the lowest lane of xmm0 register.
+	return _mm_cvtss_f32( r1 );
+}
+
+// Horizontal sum of 8 lanes of the vector
+__forceinline float hadd_ps( __m256 r8 )
+{
+	const __m128 low = _mm256_castps256_ps128( r8 );
+	const __m128 high = _mm256_extractf128_ps( r8, 1 );
+	return hadd_ps( _mm_add_ps( low, high ) );
+}
+
+// Horizontal minimum of 8 lanes of the vector
+__forceinline float hmin_ps( __m256 r8 )
+{
+	const __m128 r4 = _mm_min_ps( _mm256_castps256_ps128( r8 ), _mm256_extractf128_ps( r8, 1 ) );
+	const __m128 r2 = _mm_min_ps( r4, _mm_movehl_ps( r4, r4 ) );
+	const __m128 r1 = _mm_min_ss( r2, _mm_movehdup_ps( r2 ) );
+	return _mm_cvtss_f32( r1 );
+}
+
+// Horizontal maximum of 8 lanes of the vector
+__forceinline float hmax_ps( __m256 r8 )
+{
+	const __m128 r4 = _mm_max_ps( _mm256_castps256_ps128( r8 ), _mm256_extractf128_ps( r8, 1 ) );
+	const __m128 r2 = _mm_max_ps( r4, _mm_movehl_ps( r4, r4 ) );
+	const __m128 r1 = _mm_max_ss( r2, _mm_movehdup_ps( r2 ) );
+	return _mm_cvtss_f32( r1 );
+}
+
+// Compute a * b + acc; compiles either into a single FMA instruction, or into 2 separate SSE 1 instructions.
+template<bool fma>
+__forceinline __m128 fmadd_ps( __m128 a, __m128 b, __m128 acc )
+{
+	if constexpr( fma )
+		return _mm_fmadd_ps( a, b, acc );
+	else
+		return _mm_add_ps( _mm_mul_ps( a, b ), acc );
+}
+
+// Same as above, for 8-wide AVX vectors
+template<bool fma>
+__forceinline __m256 fmadd_ps( __m256 a, __m256 b, __m256 acc )
+{
+	if constexpr( fma )
+		return _mm256_fmadd_ps( a, b, acc );
+	else
+		return _mm256_add_ps( _mm256_mul_ps( a, b ), acc );
+}
+
+// Load the remaining 1-3 floats into the vector, set the rest of the lanes to zero.
+// SSE doesn't have masked loads, using narrower loads instead. Unlike a complete 16-bytes load, this never reads past the end of the array.
+__forceinline __m128 loadPartial( const float* p, size_t count )
+{
+	assert( count > 0 && count < 4 );
+	switch( count )
+	{
+	case 1:
+		return _mm_load_ss( p );
+	case 2:
+		return _mm_castpd_ps( _mm_load_sd( (const double*)p ) );
+	default:
+		return _mm_movelh_ps( _mm_castpd_ps( _mm_load_sd( (const double*)p ) ), _mm_load_ss( p + 2 ) );
+	}
+}
+
+// Multiply + accumulate the remaining 0-3 floats
+template<bool fma>
+__forceinline __m128 fmaddRemainder( const float* p1, const float* p2, size_t remainder, __m128 acc )
+{
+	if( 0 == remainder )
+		return acc;
+	const __m128 a = loadPartial( p1, remainder );
+	const __m128 b = loadPartial( p2, remainder );
+	return fmadd_ps<fma>( a, b, acc );
+}
+
+#ifdef __AVX__
+// The masked loads are only available in source files compiled for AVX or newer.
+
+// 8 set lanes followed by 8 zero lanes, an unaligned load from the middle of the array makes a mask for _mm256_maskload_ps
+alignas( 64 ) static const int32_t s_remainderMaskSource[ 16 ] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// Make a mask for _mm256_maskload_ps which only loads the initial `count` lanes, count must be in [ 0 .. 8 ] interval.
+__forceinline __m256i remainderMask( size_t count )
+{
+	assert( count <= 8 );
+	return _mm256_loadu_si256( ( const __m256i* )( s_remainderMaskSource + 8 - count ) );
+}
+
+// Multiply + accumulate the remaining 0-7 floats.
+// Masked loads don't access memory in the masked out lanes, they never fail even when the next page is not readable.
+template<bool fma>
+__forceinline __m256 fmaddRemainder( const float* p1, const float* p2, size_t remainder, __m256 acc )
+{
+	if( 0 == remainder )
+		return acc;
+	const __m256i mask = remainderMask( remainder );
+	const __m256 a = _mm256_maskload_ps( p1, mask );
+	const __m256 b = _mm256_maskload_ps( p2, mask );
+	return fmadd_ps<fma>( a, b, acc );
+}
+#endif
+
+// ==== Vertical SSE version, with single accumulator register ====
+
+template<bool fma>
+__forceinline float sse_vertical( const float* p1, const float* p2, size_t count )
+{
+	// The count doesn't need to be a multiple of 4, the remainder is handled after the main loop.
+	const float* const p1End = p1 + ( count - count % 4 );
+
+	__m128 acc = _mm_setzero_ps();
+	// For the first 4 values we don't have anything to add yet, just multiplying
+	if( count >= 4 )
+	{
+		const __m128 a = _mm_loadu_ps( p1 );
+		const __m128 b = _mm_loadu_ps( p2 );
+		acc = _mm_mul_ps( a, b );
+		p1 += 4;
+		p2 += 4;
+	}
+	for( ; p1 < p1End; p1 += 4, p2 += 4 )
+	{
+		const __m128 a = _mm_loadu_ps( p1 );
+		const __m128 b = _mm_loadu_ps( p2 );
+		acc = fmadd_ps<fma>( a, b, acc );
+	}
+	acc = fmaddRemainder<fma>( p1, p2, count % 4, acc );
+	return hadd_ps( acc );
+}
+
+// ==== Vertical AVX version, with single accumulator register ====
+
+template<bool fma>
+__forceinline float avx_vertical( const float* p1, const float* p2, size_t count )
+{
+	// The count doesn't need to be a multiple of 8, the remainder is handled after the main loop.
+	const float* const p1End = p1 + ( count - count % 8 );
+
+	__m256 acc = _mm256_setzero_ps();
+	// For the first 8 values we don't have anything to add yet, just multiplying
+	if( count >= 8 )
+	{
+		const __m256 a = _mm256_loadu_ps( p1 );
+		const __m256 b = _mm256_loadu_ps( p2 );
+		acc = _mm256_mul_ps( a, b );
+		p1 += 8;
+		p2 += 8;
+	}
+
+	for( ; p1 < p1End; p1 += 8, p2 += 8 )
+	{
+		const __m256 a = _mm256_loadu_ps( p1 );
+		const __m256 b = _mm256_loadu_ps( p2 );
+		acc = fmadd_ps<fma>( a, b, acc );
+	}
+	acc = fmaddRemainder<fma>( p1, p2, count % 8, acc );
+	return hadd_ps( acc );
+}
+
+// ==== Vertical SSE version, with up to 4 independent accumulators ====
+
+template<int accumulators, bool fma = true>
+__forceinline float sse_vertical_multi( const float* p1, const float* p2, size_t count )
+{
+	static_assert( accumulators > 1 && accumulators <= 4 );
+	constexpr int valuesPerLoop = accumulators * 4;
+	// The count doesn't need to be a multiple of valuesPerLoop, the remainder is handled after the main loop.
+	const size_t remainder = count % valuesPerLoop;
+	const float* const p1End = p1 + ( count - remainder );
+
+	// These independent accumulators.
+	// Depending on the accumulators template argument, some are unused, "unreferenced local variable" warning is OK.
+	__m128 dot0, dot1, dot2, dot3;
+
+	// For the first few values we don't have anything to add yet, just multiplying
+	if( count < valuesPerLoop )
+	{
+		// Too short for the main loop
+		dot0 = dot1 = dot2 = dot3 = _mm_setzero_ps();
+	}
+	else
+	{
+		__m128 a = _mm_loadu_ps( p1 );
+		__m128 b = _mm_loadu_ps( p2 );
+		dot0 = _mm_mul_ps( a, b );
+		if constexpr( accumulators > 1 )
+		{
+			a = _mm_loadu_ps( p1 + 4 );
+			b = _mm_loadu_ps( p2 + 4 );
+			dot1 = _mm_mul_ps( a, b );
+		}
+		if constexpr( accumulators > 2 )
+		{
+			a = _mm_loadu_ps( p1 + 8 );
+			b = _mm_loadu_ps( p2 + 8 );
+			dot2 = _mm_mul_ps( a, b );
+		}
+		if constexpr( accumulators > 3 )
+		{
+			a = _mm_loadu_ps( p1 + 12 );
+			b = _mm_loadu_ps( p2 + 12 );
+			dot3 = _mm_mul_ps( a, b );
+		}
+		p1 += valuesPerLoop;
+		p2 += valuesPerLoop;
+	}
+
+	// The main loop, reads valuesPerLoop floats from both vectors.
+	for( ; p1 < p1End; p1 += valuesPerLoop, p2 += valuesPerLoop )
+	{
+		__m128 a = _mm_loadu_ps( p1 );
+		__m128 b = _mm_loadu_ps( p2 );
+		dot0 = fmadd_ps<fma>( a, b, dot0 );
+		if constexpr( accumulators > 1 )
+		{
+			a = _mm_loadu_ps( p1 + 4 );
+			b = _mm_loadu_ps( p2 + 4 );
+			dot1 = fmadd_ps<fma>( a, b, dot1 );
+		}
+		if constexpr( accumulators > 2 )
+		{
+			a = _mm_loadu_ps( p1 + 8 );
+			b = _mm_loadu_ps( p2 + 8 );
+			dot2 = fmadd_ps<fma>( a, b, dot2 );
+		}
+		if constexpr( accumulators > 3 )
+		{
+			a = _mm_loadu_ps( p1 + 12 );
+			b = _mm_loadu_ps( p2 + 12 );
+			dot3 = fmadd_ps<fma>( a, b, dot3 );
+		}
+	}
+
+	// Up to 3 remaining complete vectors, each one goes into another accumulator
+	const size_t remainingVectors = remainder / 4;
+	if( remainingVectors > 0 )
+		dot0 = fmadd_ps<fma>( _mm_loadu_ps( p1 ), _mm_loadu_ps( p2 ), dot0 );
+	if constexpr( accumulators > 2 )
+	{
+		if( remainingVectors > 1 )
+			dot1 = fmadd_ps<fma>( _mm_loadu_ps( p1 + 4 ), _mm_loadu_ps( p2 + 4 ), dot1 );
+	}
+	if constexpr( accumulators > 3 )
+	{
+		if( remainingVectors > 2 )
+			dot2 = fmadd_ps<fma>( _mm_loadu_ps( p1 + 8 ), _mm_loadu_ps( p2 + 8 ), dot2 );
+	}
+	p1 += remainingVectors * 4;
+	p2 += remainingVectors * 4;
+	// The remaining 1-3 floats
+	dot0 = fmaddRemainder<fma>( p1, p2, remainder % 4, dot0 );
+
+	// Add the accumulators together into dot0. Using pairwise approach for slightly better precision, with 4 accumulators we compute ( d0 + d1 ) + ( d2 + d3 ).
+	if constexpr( accumulators > 1 )
+		dot0 = _mm_add_ps( dot0, dot1 );
+	if constexpr( accumulators > 3 )
+		dot2 = _mm_add_ps( dot2, dot3 );
+	if constexpr( accumulators > 2 )
+		dot0 = _mm_add_ps( dot0, dot2 );
+	// Compute horizontal sum of all 4 lanes in dot0
+	return hadd_ps( dot0 );
+}
+
+// ==== Vertical AVX version, with up to 4 independent accumulators ====
+
+template<int accumulators, bool fma = true>
+__forceinline float avx_vertical_multi( const float* p1, const float* p2, size_t count )
+{
+	static_assert( accumulators > 1 && accumulators <= 4 );
+	constexpr int valuesPerLoop = accumulators * 8;
+	// The count doesn't need to be a multiple of valuesPerLoop, the remainder is handled after the main loop.
+	const size_t remainder = count % valuesPerLoop;
+	const float* const p1End = p1 + ( count - remainder );
+
+	// These independent accumulators.
+	// Depending on the accumulators template argument, some are unused, "unreferenced local variable" warning is OK.
+	__m256 dot0, dot1, dot2, dot3;
+
+	// For the first few values we don't have anything to add yet, just multiplying
+	if( count < valuesPerLoop )
+	{
+		// Too short for the main loop
+		dot0 = dot1 = dot2 = dot3 = _mm256_setzero_ps();
+	}
+	else
+	{
+		__m256 a = _mm256_loadu_ps( p1 );
+		__m256 b = _mm256_loadu_ps( p2 );
+		dot0 = _mm256_mul_ps( a, b );
+		if constexpr( accumulators > 1 )
+		{
+			a = _mm256_loadu_ps( p1 + 8 );
+			b = _mm256_loadu_ps( p2 + 8 );
+			dot1 = _mm256_mul_ps( a, b );
+		}
+		if constexpr( accumulators > 2 )
+		{
+			a = _mm256_loadu_ps( p1 + 16 );
+			b = _mm256_loadu_ps( p2 + 16 );
+			dot2 = _mm256_mul_ps( a, b );
+		}
+		if constexpr( accumulators > 3 )
+		{
+			a = _mm256_loadu_ps( p1 + 24 );
+			b = _mm256_loadu_ps( p2 + 24 );
+			dot3 = _mm256_mul_ps( a, b );
+		}
+		p1 += valuesPerLoop;
+		p2 += valuesPerLoop;
+	}
+
+	for( ; p1 < p1End; p1 += valuesPerLoop, p2 += valuesPerLoop )
+	{
+		__m256 a = _mm256_loadu_ps( p1 );
+		__m256 b = _mm256_loadu_ps( p2 );
+		dot0 = fmadd_ps<fma>( a, b, dot0 );
+		if constexpr( accumulators > 1 )
+		{
+			a = _mm256_loadu_ps( p1 + 8 );
+			b = _mm256_loadu_ps( p2 + 8 );
+			dot1 = fmadd_ps<fma>( a, b, dot1 );
+		}
+		if constexpr( accumulators > 2 )
+		{
+			a = _mm256_loadu_ps( p1 + 16 );
+			b = _mm256_loadu_ps( p2 + 16 );
+			dot2 = fmadd_ps<fma>( a, b, dot2 );
+		}
+		if constexpr( accumulators > 3 )
+		{
+			a = _mm256_loadu_ps( p1 + 24 );
+			b = _mm256_loadu_ps( p2 + 24 );
+			dot3 = fmadd_ps<fma>( a, b, dot3 );
+		}
+	}
+
+	// Up to 3 remaining complete vectors, each one goes into another accumulator
+	const size_t remainingVectors = remainder / 8;
+	if( remainingVectors > 0 )
+		dot0 = fmadd_ps<fma>( _mm256_loadu_ps( p1 ), _mm256_loadu_ps( p2 ), dot0 );
+	if constexpr( accumulators > 2 )
+	{
+		if( remainingVectors > 1 )
+			dot1 = fmadd_ps<fma>( _mm256_loadu_ps( p1 + 8 ), _mm256_loadu_ps( p2 + 8 ), dot1 );
+	}
+	if constexpr( accumulators > 3 )
+	{
+		if( remainingVectors > 2 )
+			dot2 = fmadd_ps<fma>( _mm256_loadu_ps( p1 + 16 ), _mm256_loadu_ps( p2 + 16 ), dot2 );
+	}
+	p1 += remainingVectors * 8;
+	p2 += remainingVectors * 8;
+	// The remaining 1-7 floats
+	dot0 = fmaddRemainder<fma>( p1, p2, remainder % 8, dot0 );
+
+	// Add the accumulators together into dot0. Using pairwise approach for slightly better precision, with 4 accumulators we compute ( d0 + d1 ) + ( d2 + d3 ).
+	if constexpr( accumulators > 1 )
+		dot0 = _mm256_add_ps( dot0, dot1 );
+	if constexpr( accumulators > 3 )
+		dot2 = _mm256_add_ps( dot2, dot3 );
+	if constexpr( accumulators > 2 )
+		dot0 = _mm256_add_ps( dot0, dot2 );
+	// Return horizontal sum of all 8 lanes of dot0
+	return hadd_ps( dot0 );
+}
+
+// ==== Vertical AVX version for the length known at compile time ====
+
+template<size_t count, bool fma = true>
+__forceinline float avx_vertical_fixed( const float* p1, const float* p2 )
+{
+	static_assert( count > 0 && 0 == count % 8 );
+	constexpr size_t vectors = count / 8;
+	// Up to 4 independent accumulators: for short vectors the latency of the dependency chain matters more than throughput.
+	// 16 floats use 2 accumulators, 32 floats 4 of them, 64 floats 4 accumulators with 2 vectors each.
+	constexpr size_t accumulators = std::min( vectors, (size_t)4 );
+
+	// No setzero, no loop counter and no remainder: the first vectors are just multiplied, the rest of them are accumulated with FMA.
+	// All loop bounds are compile-time constants, the compilers unroll them completely.
+	__m256 dot[ accumulators ];
+	for( size_t i = 0; i < accumulators; i++ )
+		dot[ i ] = _mm256_mul_ps( _mm256_loadu_ps( p1 + i * 8 ), _mm256_loadu_ps( p2 + i * 8 ) );
+	for( size_t i = accumulators; i < vectors; i++ )
+		dot[ i % accumulators ] = fmadd_ps<fma>( _mm256_loadu_ps( p1 + i * 8 ), _mm256_loadu_ps( p2 + i * 8 ), dot[ i % accumulators ] );
+
+	// Pairwise sum of the accumulators, same order as avx_vertical_multi
+	if constexpr( accumulators > 1 )
+		dot[ 0 ] = _mm256_add_ps( dot[ 0 ], dot[ 1 ] );
+	if constexpr( accumulators > 3 )
+		dot[ 2 ] = _mm256_add_ps( dot[ 2 ], dot[ 3 ] );
+	if constexpr( accumulators > 2 )
+		dot[ 0 ] = _mm256_add_ps( dot[ 0 ], dot[ 2 ] );
+	return hadd_ps( dot[ 0 ] );
+}
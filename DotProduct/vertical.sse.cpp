@@ -0,0 +1,16 @@
+#include "stdafx.h"
+#include "dotproduct.h"
+#include "vertical.hpp"
+// Versions without FMA which only use 16-byte vectors, this source file is compiled for SSE 4.1
+
+template<>
+float dotProduct<eDotProductAlgorithm::SseVertical>( const float* p1, const float* p2, size_t count )
+{
+	return sse_vertical<false>( p1, p2, count );
+}
+
+template<>
+float dotProduct<eDotProductAlgorithm::SseVertical4>( const float* p1, const float* p2, size_t count )
+{
+	return sse_vertical_multi<4, false>( p1, p2, count );
+}
\ No newline at end of file
@@ -20,7 +20,8 @@ inline int strcasecmp( const char *s1, const char *s2 )
 {
 	return _stricmp( s1, s2 );
 }
-#else
+#elif !defined( _bswap )
+// GCC implements it in ia32intrin.h as a macro, older versions don't have it.
 // Reverse the byte order of 32-bit integer "a". This intrinsic is provided for conversion between little and big endian values.
 inline int _bswap( int a )
 {
@@ -68,6 +69,7 @@ enum struct eSwitch : uint8_t
 void Arguments::printHelp()
 {
 	printf( "Usage example: FloodFill -i source.png -o result.png -p 12,33 -c #FF00FF -t 30 -a Scanline\n" );
+	printf( "Append hugepages to allocate images of 2MB or more in transparent huge pages\n" );
 }
 
 // The function must have prototype similar to this: bool parseValue( eSwitch sw, const char* str )
@@ -204,6 +206,12 @@ bool Arguments::parseAlgorithm( const char* str )
 		printf( "Unknown algorithm \"%s\"\n", str );
 		return false;
 	}
+	if( !isSupported( requiredInstructionSet( algorithm ) ) )
+	{
+		printf( "Algorithm \"%s\" requires %s, this CPU only supports %s\n", str,
+			instructionSetName( requiredInstructionSet( algorithm ) ), instructionSetName( supportedInstructionSet() ) );
+		return false;
+	}
 	return true;
 }
 
@@ -224,6 +232,26 @@ bool Arguments::parseTolerance( const char* str )
 	return true;
 }
 
+eInstructionSet requiredInstructionSet( eFloodFillAlgorithm algo )
+{
+	switch( algo )
+	{
+	case eFloodFillAlgorithm::Scanline:
+		return eInstructionSet::Sse2;
+	case eFloodFillAlgorithm::VectorBlocksBits:
+		return eInstructionSet::Avx2;
+	}
+	assert( false );
+	return eInstructionSet::Avx2;
+}
+
+eFloodFillAlgorithm fastestAlgorithm()
+{
+	// The vectorized version is built on 32-byte integer instructions, these are from AVX2. No point in porting it to SSE, the scanline is good enough for these old CPUs.
+	static const eFloodFillAlgorithm fastest = isSupported( eInstructionSet::Avx2 ) ? eFloodFillAlgorithm::VectorBlocksBits : eFloodFillAlgorithm::Scanline;
+	return fastest;
+}
+
 Arguments::pfnFillFunc Arguments::fillFunc() const
 {
 	switch( algorithm )
@@ -6,8 +6,8 @@ struct Arguments
 {
 	// Default both to invalid
 	const char* source = nullptr, *destination = nullptr;
-	// Default to vector version
-	eFloodFillAlgorithm algorithm = eFloodFillAlgorithm::VectorBlocksBits;
+	// Default to the fastest version supported by the CPU
+	eFloodFillAlgorithm algorithm = fastestAlgorithm();
 	// Default to invalid
 	CPoint startingPoint = CPoint{ -1, -1 };
 	// Default to green
@@ -209,7 +209,7 @@ void ScanlineFill::fillLine( const Scanline& line )
 template<>
 void floodFill<eFloodFillAlgorithm::Scanline>( Image& image, CPoint pt, uint32_t fillColor, uint8_t tolerance )
 {
-	PerfTimer __timer( "eFloodFillAlgorithm::Scanline" );
+	PerfTimer __timer( "eFloodFillAlgorithm::Scanline", (size_t)image.size.cx * (size_t)image.size.cy );
 	ScanlineFill fill{ image, pt, fillColor, tolerance };
 	fill.run( pt );
 }
\ No newline at end of file
@@ -7,7 +7,11 @@
 // That's why using templates to handle images of widths not being multiple of 16.
 
 // A magic number to expand bits in a byte into uint32_t lanes.
-static const __m256i expandBitsMagic = _mm256_setr_epi32( 0x01010101, 0x02020202, 0x04040404, 0x08080808, 0x10101010, 0x20202020, 0x40404040, 0x80808080 );
+// It's a function not a global variable, because a global would be initialized on startup, with AVX instructions, even on CPUs which don't support them.
+__forceinline __m256i expandBitsMagic()
+{
+	return _mm256_setr_epi32( 0x01010101, 0x02020202, 0x04040404, 0x08080808, 0x10101010, 0x20202020, 0x40404040, 0x80808080 );
+}
 
 // Use bits to selectively overwrite exactly 8 pixels.
 __forceinline void fill8( uint8_t bits, uint32_t* dest, __m256i filledValue )
@@ -20,7 +24,7 @@ __forceinline void fill8( uint8_t bits, uint32_t* dest, __m256i filledValue )
 
 	// Expand 8 bits into uint32_t pixels, UINT_MAX where the bit was set, 0 otherwise
 	__m256i mask = _mm256_set1_epi8( (char)bits );	// This is AVX2, compiles into vpbroadcastb
-	const __m256i andMask = expandBitsMagic;
+	const __m256i andMask = expandBitsMagic();
 	mask = _mm256_and_si256( mask, andMask );
 	mask = _mm256_cmpeq_epi32( mask, andMask );
 
@@ -94,7 +98,7 @@ __forceinline void fillPartial( uint8_t bits, uint32_t* dest, __m256i filledValu
 
 	// Expand 8 bits into uint32_t pixels, UINT_MAX where the bit was set, 0 otherwise
 	__m256i mask = _mm256_set1_epi8( (char)bits );	// Compiles into vpbroadcastb
-	const __m256i andMask = expandBitsMagic;
+	const __m256i andMask = expandBitsMagic();
 	mask = _mm256_and_si256( mask, andMask );
 	mask = _mm256_cmpeq_epi32( mask, andMask );
 
@@ -235,7 +235,7 @@ void VectorBlocksFill::run()
 template<>
 void floodFill<eFloodFillAlgorithm::VectorBlocksBits>( Image& image, CPoint pt, uint32_t fillColor, uint8_t tolerance )
 {
-	PerfTimer __timer( "eFloodFillAlgorithm::VectorBlocksBits" );
+	PerfTimer __timer( "eFloodFillAlgorithm::VectorBlocksBits", (size_t)image.size.cx * (size_t)image.size.cy );
 
 	// Compare colors of the complete image, produce 1 bit/pixel version, laid out in memory as a 2D array of 16x16 blocks of bits.
 	PixelComparer comparer{ image[ pt ], tolerance };
@@ -12,5 +12,11 @@ enum struct eFloodFillAlgorithm : uint8_t
 
 class Image;
 
+// Get the instruction set the algorithm requires.
+eInstructionSet requiredInstructionSet( eFloodFillAlgorithm algo );
+
+// The fastest algorithm supported by this CPU, selected once on the first call.
+eFloodFillAlgorithm fastestAlgorithm();
+
 template<eFloodFillAlgorithm algo>
 void floodFill( Image& image, CPoint pt, uint32_t fillColor, uint8_t tolerance = 16 );
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 int main( int argc, const char* argv[] )
 {
+	parseHugePagesArgument( argc, argv );
 	Arguments args;
 	if( !args.parse( argc, argv ) )
 		return 1;
@@ -25,6 +26,7 @@ int main( int argc, const char* argv[] )
 			return 3;
 		}
 
+		printAllocationPolicy();
 		pfnFill( image, args.startingPoint, args.color, args.tolerance );
 		image.save( args.destination );
 		return 0;
@@ -6,8 +6,9 @@
 #include "../common.h"
 #include "floodFill.h"
 
-// GCC doesn't have a few intrinsics we use. No big deal, implementing manually on top of what's available there.
-#ifndef _MSC_VER
+// Older GCC doesn't have a few intrinsics we use. No big deal, implementing manually on top of what's available there.
+// GCC 11 finally has all of them, and fails to compile if they're redefined.
+#if !defined( _MSC_VER ) && __GNUC__ < 11
 
 // Set packed __m256i vector with the supplied values.
 __forceinline __m256i _mm256_setr_m128i( __m128i low, __m128i high )
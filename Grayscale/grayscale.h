@@ -14,7 +14,7 @@ constexpr uint16_t mulGreen = (uint16_t)( mulGreenFloat * 0x10000 );
 constexpr uint16_t mulBlue = (uint16_t)( mulBlueFloat * 0x10000 );
 
 // Create a new array of length `pixelsCount` filled with random data, not cached.
-std::unique_ptr<uint32_t[]> createRandomImage();
+std::unique_ptr<uint32_t[], details::AlignedDeleter> createRandomImage();
 
 enum struct eGrayscaleAlgorithm : uint8_t
 {
@@ -33,8 +33,14 @@ enum struct eGrayscaleAlgorithm : uint8_t
 // Get the name of the algorithm, or nullptr if the argument is invalid.
 const char* algorithmName( eGrayscaleAlgorithm algo );
 
-// Run the specified algorithm, return time in milliseconds
-double dispatchAndMeasure( eGrayscaleAlgorithm how, const uint32_t* sourcePixels, uint8_t* destinationBytes, size_t count );
+// Get the instruction set the algorithm requires.
+eInstructionSet requiredInstructionSet( eGrayscaleAlgorithm algo );
+
+// The fastest algorithm supported by this CPU, selected once on the first call.
+eGrayscaleAlgorithm fastestAlgorithm();
+
+// Run the specified algorithm, return time in milliseconds. The performance counters measure the same interval.
+double dispatchAndMeasure( eGrayscaleAlgorithm how, const uint32_t* sourcePixels, uint8_t* destinationBytes, size_t count, PerfCounters& counters );
 
 // Various *.cpp source files in this project are actually implementing specialized versions of this function.
 template<eGrayscaleAlgorithm algo>
@@ -5,18 +5,29 @@ static void printHelp()
 {
 	printf( "Valid arguments:\n" );
 	for( uint8_t i = 0; i < (uint8_t)eGrayscaleAlgorithm::valuesCount; i++ )
-		printf( "%i: %s\n", (int)i, algorithmName( (eGrayscaleAlgorithm)i ) );
+	{
+		const eGrayscaleAlgorithm algo = (eGrayscaleAlgorithm)i;
+		if( isSupported( requiredInstructionSet( algo ) ) )
+			printf( "%i: %s\n", (int)i, algorithmName( algo ) );
+		else
+			printf( "%i: %s, requires %s\n", (int)i, algorithmName( algo ), instructionSetName( requiredInstructionSet( algo ) ) );
+	}
+	printf( "auto: the fastest one supported by this CPU, %s\n", algorithmName( fastestAlgorithm() ) );
+	printf( "The algorithm can be followed by hugepages, to allocate the source and destination images in 2MB transparent huge pages\n" );
 }
 
 int main( int argc, const char* argv[] )
 {
+	parseHugePagesArgument( argc, argv );
 	if( argc != 2 )
 	{
 		printHelp();
 		return 1;
 	}
 	int algoInt;
-	if( !nonstd::atoi( argv[ 1 ], algoInt ) || algoInt < 0 || algoInt >= (int)eGrayscaleAlgorithm::valuesCount )
+	if( 0 == strcmp( argv[ 1 ], "auto" ) )
+		algoInt = (int)fastestAlgorithm();
+	else if( !nonstd::atoi( argv[ 1 ], algoInt ) || algoInt < 0 || algoInt >= (int)eGrayscaleAlgorithm::valuesCount )
 	{
 		printf( "Please provide a single integer argument, within [ 0 .. %i ] interval\n", (int)eGrayscaleAlgorithm::valuesCount - 1 );
 		printHelp();
@@ -24,9 +35,20 @@ int main( int argc, const char* argv[] )
 	}
 
 	const eGrayscaleAlgorithm algo = (eGrayscaleAlgorithm)algoInt;
+	if( !isSupported( requiredInstructionSet( algo ) ) )
+	{
+		printf( "%s requires %s, this CPU only supports %s\n", algorithmName( algo ),
+			instructionSetName( requiredInstructionSet( algo ) ), instructionSetName( supportedInstructionSet() ) );
+		return 3;
+	}
 	const auto image = createRandomImage();
-	std::vector<uint8_t> result( pixelsCount );
-	const double ms = dispatchAndMeasure( algo, image.get(), result.data(), pixelsCount );
+	auto result = alignedArray<uint8_t>( pixelsCount );
+	// Touch the output, otherwise the page faults of the first write are measured
+	memset( result.get(), 0, pixelsCount );
+	printAllocationPolicy();
+	PerfCounters counters;
+	const double ms = dispatchAndMeasure( algo, image.get(), result.get(), pixelsCount, counters );
 	printf( "%s: %g ms\n", algorithmName( algo ), ms );
+	counters.print( pixelsCount );
 	return 0;
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "stdafx.h"
 #include "grayscale.h"
 
-std::unique_ptr<uint32_t[]> createRandomImage()
+std::unique_ptr<uint32_t[], details::AlignedDeleter> createRandomImage()
 {
 	std::independent_bits_engine<std::default_random_engine, 32, uint32_t> re{ 11 };
 	std::vector<uint32_t> data( pixelsCount );
@@ -9,7 +9,7 @@ std::unique_ptr<uint32_t[]> createRandomImage()
 
 	// To simulate externally-supplied image, evict the vector from CPU cache.
 	// Allocate an array of pixels, and copy the data with stream store instructions.
-	std::unique_ptr<uint32_t[]> ramCopy( new uint32_t[ pixelsCount ] );
+	auto ramCopy = alignedArray<uint32_t>( pixelsCount );
 	const uint32_t* source = data.data();
 	const uint32_t* sourceEnd = source + pixelsCount;
 	uint32_t* dest = ramCopy.get();
@@ -36,19 +36,60 @@ const char* algorithmName( eGrayscaleAlgorithm algo )
 	return nullptr;
 }
 
+eInstructionSet requiredInstructionSet( eGrayscaleAlgorithm algo )
+{
+	switch( algo )
+	{
+	case eGrayscaleAlgorithm::ScalarFloats:
+	case eGrayscaleAlgorithm::ScalarInt16:
+	case eGrayscaleAlgorithm::SseFloat:
+		return eInstructionSet::Sse2;
+	case eGrayscaleAlgorithm::SseInt16:
+		return eInstructionSet::Sse41;
+	case eGrayscaleAlgorithm::SseFloatFma:
+	case eGrayscaleAlgorithm::AvxFloat:
+	case eGrayscaleAlgorithm::AvxFloatFma:
+	case eGrayscaleAlgorithm::AvxInt16:
+		return eInstructionSet::Avx2;
+	}
+	return eInstructionSet::Avx2;
+}
+
+eGrayscaleAlgorithm fastestAlgorithm()
+{
+	static const eGrayscaleAlgorithm fastest = []()
+	{
+		switch( supportedInstructionSet() )
+		{
+		case eInstructionSet::Avx2:
+			return eGrayscaleAlgorithm::AvxInt16;
+		case eInstructionSet::Avx:
+		case eInstructionSet::Sse41:
+			// None of the algorithms need AVX without AVX2, 32-byte integer instructions are from AVX2.
+			return eGrayscaleAlgorithm::SseInt16;
+		default:
+			return eGrayscaleAlgorithm::SseFloat;
+		}
+	}();
+	return fastest;
+}
+
 template<eGrayscaleAlgorithm algo>
-static double measure( const uint32_t* sourcePixels, uint8_t* destinationBytes, size_t count )
+static double measure( const uint32_t* sourcePixels, uint8_t* destinationBytes, size_t count, PerfCounters& counters )
 {
+	counters.start();
 	const Stopwatch stopwatch;
 	convertToGrayscale<algo>( sourcePixels, destinationBytes, count );
-	return stopwatch.elapsedMilliseconds();
+	const double ms = stopwatch.elapsedMilliseconds();
+	counters.stop();
+	return ms;
 }
 
-double dispatchAndMeasure( eGrayscaleAlgorithm how, const uint32_t* sourcePixels, uint8_t* destinationBytes, size_t count )
+double dispatchAndMeasure( eGrayscaleAlgorithm how, const uint32_t* sourcePixels, uint8_t* destinationBytes, size_t count, PerfCounters& counters )
 {
 	switch( how )
 	{
-#define AN( T ) case eGrayscaleAlgorithm::T: return measure<eGrayscaleAlgorithm::T>( sourcePixels, destinationBytes, count );
+#define AN( T ) case eGrayscaleAlgorithm::T: return measure<eGrayscaleAlgorithm::T>( sourcePixels, destinationBytes, count, counters );
 		AN( ScalarFloats );
 		AN( ScalarInt16 );
 		AN( SseFloat );
@@ -4,12 +4,20 @@
 #include <assert.h>
 #include <stdio.h>
 #include <climits>
+#include <float.h>
 #include <string.h>
+#include <errno.h>
 
 // SSE SIMD intrinsics
 #include <xmmintrin.h>
 // AVX SIMD intrinsics
 #include <immintrin.h>
+// CPUID instruction
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
 
 // Common C++ stuff
 #include <vector>
@@ -18,6 +26,19 @@
 #include <algorithm>
 #include <random>
 #include <chrono>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+
+// Hardware performance counters
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+// madvise for huge pages
+#include <sys/mman.h>
+#endif
 
 // A wrapper around std::chrono::high_resolution_clock which starts measuring time once constructed, and reports elapsed time
 class Stopwatch
@@ -52,19 +73,215 @@ public:
 	}
 };
 
+// Hardware performance counters of the calling thread: cycles, instructions, L1D, LLC and data TLB read misses, branch misses.
+// Implemented with perf_event_open on Linux. The counters are unavailable on other OSes, in VMs without virtual PMU, or when kernel.perf_event_paranoid doesn't allow them;
+// then the methods do nothing, and print() says why. Individual counters the CPU doesn't have are reported as n/a.
+class PerfCounters
+{
+public:
+	enum eCounter : uint8_t
+	{
+		Cycles,
+		Instructions,
+		L1dMisses,
+		LlcMisses,
+		DtlbMisses,
+		BranchMisses,
+		countersCount
+	};
+
+private:
+	// Position of each counter in the group, or -1 if it failed to open
+	std::array<int, countersCount> index;
+	std::array<uint64_t, countersCount> values = {};
+	std::vector<int> descriptors;
+	int error = 0;
+	bool measured = false;
+	// Fraction of the measured time the group was on the PMU, less than 1 when the kernel multiplexed it with other events
+	double runningFraction = 1;
+
+#ifdef __linux__
+	int open( uint32_t type, uint64_t config, int groupLeader )
+	{
+		perf_event_attr attr = {};
+		attr.size = sizeof( attr );
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = ( groupLeader < 0 ) ? 1 : 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return (int)syscall( __NR_perf_event_open, &attr, 0, -1, groupLeader, 0 );
+	}
+
+	static constexpr uint64_t cacheMiss( uint64_t cache )
+	{
+		return cache | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+	}
+#endif
+
+public:
+	PerfCounters()
+	{
+		index.fill( -1 );
+#ifdef __linux__
+		const std::array<std::pair<uint32_t, uint64_t>, countersCount> events =
+		{ {
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+			{ PERF_TYPE_HW_CACHE, cacheMiss( PERF_COUNT_HW_CACHE_L1D ) },
+			{ PERF_TYPE_HW_CACHE, cacheMiss( PERF_COUNT_HW_CACHE_LL ) },
+			{ PERF_TYPE_HW_CACHE, cacheMiss( PERF_COUNT_HW_CACHE_DTLB ) },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		} };
+		// Cycles counter is the group leader, without it there's no group
+		for( size_t i = 0; i < countersCount; i++ )
+		{
+			const int fd = open( events[ i ].first, events[ i ].second, descriptors.empty() ? -1 : descriptors[ 0 ] );
+			if( fd < 0 )
+			{
+				if( descriptors.empty() )
+				{
+					error = errno;
+					return;
+				}
+				continue;
+			}
+			index[ i ] = (int)descriptors.size();
+			descriptors.push_back( fd );
+		}
+#else
+		error = ENOSYS;
+#endif
+	}
+
+	~PerfCounters()
+	{
+#ifdef __linux__
+		for( int fd : descriptors )
+			close( fd );
+#endif
+	}
+
+	PerfCounters( const PerfCounters& ) = delete;
+	void operator=( const PerfCounters& ) = delete;
+
+	bool available() const
+	{
+		return !descriptors.empty();
+	}
+
+	// Reset and start counting
+	void start()
+	{
+#ifdef __linux__
+		if( !available() )
+			return;
+		ioctl( descriptors[ 0 ], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+		ioctl( descriptors[ 0 ], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+#endif
+	}
+
+	// Stop counting, and read the values
+	void stop()
+	{
+#ifdef __linux__
+		if( !available() )
+			return;
+		ioctl( descriptors[ 0 ], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP );
+
+		// The group read format: count of values, time enabled, time running, then the values in the order they were opened
+		std::array<uint64_t, 3 + countersCount> buffer;
+		const ssize_t cb = read( descriptors[ 0 ], buffer.data(), sizeof( buffer ) );
+		// When the PMU can't fit the complete group, the kernel doesn't run it at all
+		if( cb < (ssize_t)( ( 3 + descriptors.size() ) * sizeof( uint64_t ) ) || 0 == buffer[ 2 ] )
+		{
+			error = ( cb < 0 ) ? errno : EBUSY;
+			return;
+		}
+		// When the group was time-shared with other events, extrapolate the values to the complete time it was enabled
+		runningFraction = (double)buffer[ 2 ] / (double)std::max( buffer[ 1 ], buffer[ 2 ] );
+		for( size_t i = 0; i < countersCount; i++ )
+			values[ i ] = ( index[ i ] < 0 ) ? 0 : (uint64_t)std::llround( (double)buffer[ 3 + index[ i ] ] / runningFraction );
+		measured = true;
+#endif
+	}
+
+	// Value of the counter, or 0 if it's unavailable
+	uint64_t value( eCounter c ) const
+	{
+		return values[ c ];
+	}
+
+	bool hasValue( eCounter c ) const
+	{
+		return measured && index[ c ] >= 0;
+	}
+
+	// Print IPC, and the misses per element of the input. Prints the reason when the counters are unavailable.
+	void print( size_t elements ) const
+	{
+		if( !measured )
+		{
+			printf( "Performance counters are unavailable: %s\n", strerror( error ) );
+			return;
+		}
+		const double cycles = (double)values[ Cycles ];
+		const double mul = 1.0 / (double)std::max( elements, (size_t)1 );
+		printf( "%g cycles", cycles );
+		if( hasValue( Instructions ) )
+			printf( ", %g instructions, IPC %.2f", (double)values[ Instructions ], (double)values[ Instructions ] / cycles );
+		const std::array<std::pair<eCounter, const char*>, 4> misses =
+		{ {
+			{ L1dMisses, "L1D misses" },
+			{ LlcMisses, "LLC misses" },
+			{ DtlbMisses, "dTLB misses" },
+			{ BranchMisses, "branch misses" },
+		} };
+		for( const auto& m : misses )
+		{
+			if( hasValue( m.first ) )
+				printf( ", %s %.4f", m.second, (double)values[ m.first ] * mul );
+			else
+				printf( ", %s n/a", m.second );
+		}
+		printf( " per element" );
+		if( runningFraction < 1 )
+			printf( ", multiplexed: counted %.0f%% of the time, the values are scaled", runningFraction * 100 );
+		printf( "\n" );
+	}
+};
+
 // A wrapper around std::chrono::high_resolution_clock which prints the time passed between constructor and destructor.
+// When constructed with non-zero count of elements, also prints hardware performance counters.
 class PerfTimer
 {
 	const char* const what;
+	const size_t elements;
+	std::unique_ptr<PerfCounters> counters;
 	const Stopwatch stopwatch;
 
+	static std::unique_ptr<PerfCounters> startCounters( size_t elements )
+	{
+		if( 0 == elements )
+			return nullptr;
+		auto res = std::make_unique<PerfCounters>();
+		res->start();
+		return res;
+	}
+
 public:
-	PerfTimer( const char* measure ) : what( measure ) { }
+	PerfTimer( const char* measure, size_t elements = 0 ) :
+		what( measure ), elements( elements ), counters( startCounters( elements ) ) { }
 
 	~PerfTimer()
 	{
 		const double ms = stopwatch.elapsedMilliseconds();
+		if( counters )
+			counters->stop();
 		printf( "%s: %g ms\n", what, ms );
+		if( counters )
+			counters->print( elements );
 	}
 };
 #define MEASURE_THIS_FUNCTION() PerfTimer __time{ __func__  }
@@ -87,8 +304,23 @@ namespace nonstd
 	}
 }
 
+// How alignedMalloc and alignedArray allocate large blocks of memory
+enum struct eAllocationPolicy : uint8_t
+{
+	// Only the requested alignment
+	Default,
+	// Blocks of 2MB or more are aligned and padded to 2MB, and advised with madvise( MADV_HUGEPAGE ) so the kernel backs them with transparent huge pages.
+	// This reduces TLB misses when streaming through large arrays. Only implemented on Linux: large pages on Windows require SeLockMemoryPrivilege and VirtualAlloc.
+	HugePages,
+};
+
 namespace details
 {
+	constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+	// The policy of the whole program, set once by main() before allocating anything
+	inline eAllocationPolicy s_allocationPolicy = eAllocationPolicy::Default;
+
 	// Unfortunately, VC++ doesn't support std::aligned_alloc from C++/17 spec:
 	// https://developercommunity.visualstudio.com/content/problem/468021/c17-stdaligned-alloc缺失.html
 
@@ -97,6 +329,15 @@ namespace details
 	{
 #ifdef _MSC_VER
 		return _aligned_malloc( size, alignment );
+#elif defined( __linux__ )
+		if( eAllocationPolicy::HugePages != s_allocationPolicy || size < hugePageSize )
+			return aligned_alloc( alignment, size );
+		size = ( size + hugePageSize - 1 ) / hugePageSize * hugePageSize;
+		void* const pointer = aligned_alloc( std::max( alignment, hugePageSize ), size );
+		// Just an advice: the kernel may have THP disabled, or fail to find free 2MB pages. Then the block stays in 4kb pages.
+		if( nullptr != pointer )
+			madvise( pointer, size, MADV_HUGEPAGE );
+		return pointer;
 #else
 		return aligned_alloc( alignment, size );
 #endif
@@ -148,7 +389,61 @@ namespace details
 	};
 }
 
-// Allocate and return block of memory aligned by at least 32 bytes. This does not call constructors, the memory is uninitialized. Destructors aren't called, either.
+inline void setAllocationPolicy( eAllocationPolicy policy )
+{
+	details::s_allocationPolicy = policy;
+}
+
+inline eAllocationPolicy allocationPolicy()
+{
+	return details::s_allocationPolicy;
+}
+
+// If the last command-line argument is "hugepages", switch the allocation policy to huge pages and remove that argument.
+inline void parseHugePagesArgument( int& argc, const char* argv[] )
+{
+	if( argc < 2 || 0 != strcmp( argv[ argc - 1 ], "hugepages" ) )
+		return;
+	setAllocationPolicy( eAllocationPolicy::HugePages );
+	argc--;
+}
+
+// Print the allocation policy. On Linux, also the THP mode of the kernel, and how much of the process memory is in transparent huge pages.
+inline void printAllocationPolicy()
+{
+	const bool huge = eAllocationPolicy::HugePages == allocationPolicy();
+	printf( "Allocation policy: %s", huge ? "huge pages for blocks of 2MB or more" : "default" );
+#ifdef __linux__
+	char line[ 256 ];
+	FILE* file = fopen( "/sys/kernel/mm/transparent_hugepage/enabled", "r" );
+	if( nullptr != file )
+	{
+		if( nullptr != fgets( line, sizeof( line ), file ) )
+		{
+			line[ strcspn( line, "\n" ) ] = '\0';
+			printf( "; THP mode: %s", line );
+		}
+		fclose( file );
+	}
+	file = fopen( "/proc/self/smaps_rollup", "r" );
+	if( nullptr != file )
+	{
+		while( nullptr != fgets( line, sizeof( line ), file ) )
+		{
+			unsigned long long kb;
+			if( 1 == sscanf( line, "AnonHugePages: %llu kB", &kb ) )
+			{
+				printf( "; %g MB in huge pages", (double)kb / 1024.0 );
+				break;
+			}
+		}
+		fclose( file );
+	}
+#endif
+	printf( "\n" );
+}
+
+// Allocate and return block of memory aligned by at least 32 bytes, or 2MB for large blocks with eAllocationPolicy::HugePages. This does not call constructors, the memory is uninitialized. Destructors aren't called, either.
 // If that's not what you want, you can wrap alignedMalloc/alignedFree into custom allocator, and use std::vector instead: https://stackoverflow.com/a/12942652/126995
 template<class T>
 inline std::unique_ptr<T[], details::AlignedDeleter> alignedArray( size_t size )
@@ -165,6 +460,99 @@ inline std::unique_ptr<T[], details::AlignedDeleter> alignedArray( size_t size )
 	return std::unique_ptr<T[], details::AlignedDeleter>{ pointer };
 }
 
+// Instruction set levels the programs are compiled for. Every level includes all previous ones.
+// Only the source files with the kernels are compiled for higher levels, the rest of the program runs on any AMD64 CPU.
+enum struct eInstructionSet : uint8_t
+{
+	Sse2,
+	Sse41,
+	Avx,
+	// AVX2 + FMA3, also F16C and POPCNT which every CPU with AVX2 supports
+	Avx2,
+};
+
+namespace details
+{
+	// Run CPUID instruction, return EAX, EBX, ECX, EDX registers
+	inline std::array<uint32_t, 4> cpuid( uint32_t leaf, uint32_t subleaf = 0 )
+	{
+		std::array<uint32_t, 4> regs;
+#ifdef _MSC_VER
+		__cpuidex( (int*)regs.data(), (int)leaf, (int)subleaf );
+#else
+		__cpuid_count( leaf, subleaf, regs[ 0 ], regs[ 1 ], regs[ 2 ], regs[ 3 ] );
+#endif
+		return regs;
+	}
+
+	// Read XCR0 register, it has the register states the OS saves and restores on context switches.
+	inline uint64_t xgetbv0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv( 0 );
+#else
+		// _xgetbv intrinsic requires -mxsave compiler switch, that's why inline assembly.
+		uint32_t eax, edx;
+		__asm__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+		return ( (uint64_t)edx << 32 ) | eax;
+#endif
+	}
+
+	inline eInstructionSet detectInstructionSet()
+	{
+		const uint32_t maxLeaf = cpuid( 0 )[ 0 ];
+		const std::array<uint32_t, 4> leaf1 = cpuid( 1 );
+		const uint32_t ecx = leaf1[ 2 ];
+
+		// SSE2 is a part of AMD64 spec, every 64-bit CPU has it.
+		constexpr uint32_t sse41Bit = 1u << 19;
+		if( 0 == ( ecx & sse41Bit ) )
+			return eInstructionSet::Sse2;
+
+		// AVX is only usable when the OS saves upper halves of the registers. OSXSAVE bit means we can ask the OS with xgetbv instruction.
+		constexpr uint32_t avxBits = ( 1u << 27 ) | ( 1u << 28 );
+		if( avxBits != ( ecx & avxBits ) )
+			return eInstructionSet::Sse41;
+		// Bit 1 is SSE state, bit 2 is AVX state
+		if( 6 != ( xgetbv0() & 6 ) )
+			return eInstructionSet::Sse41;
+
+		constexpr uint32_t fmaBits = ( 1u << 12 ) | ( 1u << 23 ) | ( 1u << 29 );	// FMA3, POPCNT and F16C
+		if( maxLeaf < 7 || fmaBits != ( ecx & fmaBits ) )
+			return eInstructionSet::Avx;
+		constexpr uint32_t avx2Bit = 1u << 5;
+		if( 0 == ( cpuid( 7 )[ 1 ] & avx2Bit ) )
+			return eInstructionSet::Avx;
+		return eInstructionSet::Avx2;
+	}
+}
+
+// The highest instruction set level supported by the CPU and OS. Detected with CPUID on the first call, cached afterwards.
+inline eInstructionSet supportedInstructionSet()
+{
+	static const eInstructionSet isa = details::detectInstructionSet();
+	return isa;
+}
+
+// True if the CPU and OS support the specified instruction set level.
+inline bool isSupported( eInstructionSet isa )
+{
+	return isa <= supportedInstructionSet();
+}
+
+// Get the name of the instruction set level
+inline const char* instructionSetName( eInstructionSet isa )
+{
+	switch( isa )
+	{
+	case eInstructionSet::Sse2: return "SSE2";
+	case eInstructionSet::Sse41: return "SSE 4.1";
+	case eInstructionSet::Avx: return "AVX";
+	case eInstructionSet::Avx2: return "AVX2 + FMA3";
+	}
+	return nullptr;
+}
+
 #ifndef _MSC_VER
 // A few compatibility things for building with gcc or clang
 #define __forceinline __attribute__((always_inline)) inline